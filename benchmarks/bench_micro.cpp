@@ -0,0 +1,271 @@
+/**
+ * 热路径单元微基准：Buffer / TimerWheel / 无锁任务队列 / 日志 / 响应头构造
+ *
+ * 只链接无外部依赖的模块（HttpConn 牵扯 mysql/onnxruntime，不进这里；
+ * 它的解析热核——memchr 找 CRLF、strncasecmp 头匹配——以同款内核的
+ * 形式单独测）。每个基准都是改动前后跑一把对比 ns/op 的回归闸门。
+ *
+ * 用法：bench_micro [名字过滤子串]
+ */
+#include "benchharness.h"
+#include "buffer.h"
+#include "bufferpool.h"
+#include "timerwheel.h"
+#include "threadpool.h"
+#include "responsebuilder.h"
+#include "simd_scan.h"
+#include "log.h"
+
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+// ---------- Buffer ----------
+
+// 64 字节小块追加：模拟响应头逐段写入写缓冲
+static void BM_BufferAppend(bench::State &state)
+{
+    Buffer buff;
+    char chunk[64];
+    memset(chunk, 'x', sizeof(chunk));
+    for (auto _ : state)
+    {
+        buff.Append(chunk, sizeof(chunk));
+        if (buff.ReadAbleBytes() >= 64 * 1024)
+        {
+            buff.RetrieveAll(); // 周期性清空，测稳态而不是测扩容
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(chunk));
+}
+BENCHMARK(BM_BufferAppend);
+
+// ReadFd 全链路：socketpair 一端灌 4KB，另一端 readv 进 Buffer
+static void BM_BufferReadFd(bench::State &state)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) { return; }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    char payload[4096];
+    memset(payload, 'y', sizeof(payload));
+    Buffer buff;
+    int err = 0;
+    for (auto _ : state)
+    {
+        ssize_t n = write(fds[1], payload, sizeof(payload));
+        (void)n;
+        buff.ReadFd(fds[0], &err);
+        buff.RetrieveAll();
+    }
+    close(fds[0]);
+    close(fds[1]);
+    state.SetBytesProcessed(state.iterations() * sizeof(payload));
+}
+BENCHMARK(BM_BufferReadFd);
+
+// ---------- HTTP 解析热核 ----------
+
+// memchr 找 CRLF 逐行推进（HttpConn::ParseFromBuffer_ 的扫描内核）
+static void BM_ParseScanCRLF(bench::State &state)
+{
+    static const char REQUEST[] =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: localhost:1316\r\n"
+        "Connection: keep-alive\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "User-Agent: bench/1.0\r\n"
+        "Accept: text/html,application/xhtml+xml\r\n"
+        "\r\n";
+    const char *reqEnd = REQUEST + sizeof(REQUEST) - 1;
+    size_t lines = 0;
+    for (auto _ : state)
+    {
+        const char *p = REQUEST;
+        while (p < reqEnd)
+        {
+            const char *cr = static_cast<const char *>(memchr(p, '\r', reqEnd - p));
+            if (!cr || cr + 1 >= reqEnd || cr[1] != '\n') { break; }
+            // 头名匹配内核：和 ParseHeaderLine_ 一样在缓冲区字节上比较
+            if (cr - p >= 10 && strncasecmp(p, "Connection", 10) == 0) { lines++; }
+            p = cr + 2;
+        }
+    }
+    if (lines == 0) { printf("?"); } // 防止整个循环被优化掉
+    state.SetBytesProcessed(state.iterations() * (sizeof(REQUEST) - 1));
+}
+BENCHMARK(BM_ParseScanCRLF);
+
+// ---------- SIMD 扫描内核（标量 vs 向量对照组） ----------
+
+// 合成一块 1KB 的"头部"：行长 60 字节左右，和真实浏览器请求接近
+static const char *SimdHaystack_(size_t *outLen)
+{
+    static char block[1024];
+    static size_t len = 0;
+    if (len == 0)
+    {
+        while (len + 64 < sizeof(block))
+        {
+            int n = snprintf(block + len, sizeof(block) - len,
+                             "X-Header-%02zu: some-plausible-value-padding-here\r\n", len % 100);
+            len += (size_t)n;
+        }
+    }
+    *outLen = len;
+    return block;
+}
+
+// 同一份数据分别用标量版和分发版跑 FindCRLF，对照证明 SIMD 的收益
+static void BM_FindCRLFScalar(bench::State &state)
+{
+    size_t len = 0;
+    const char *block = SimdHaystack_(&len);
+    size_t lines = 0;
+    for (auto _ : state)
+    {
+        const char *p = block;
+        const char *end = block + len;
+        const char *cr;
+        while ((cr = SimdScan::FindCRLFScalar(p, end)) != nullptr) { lines++; p = cr + 2; }
+    }
+    if (lines == 0) { printf("?"); }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_FindCRLFScalar);
+
+static void BM_FindCRLFSimd(bench::State &state)
+{
+    size_t len = 0;
+    const char *block = SimdHaystack_(&len);
+    size_t lines = 0;
+    for (auto _ : state)
+    {
+        const char *p = block;
+        const char *end = block + len;
+        const char *cr;
+        while ((cr = SimdScan::FindCRLF(p, end)) != nullptr) { lines++; p = cr + 2; }
+    }
+    if (lines == 0) { printf("?"); }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_FindCRLFSimd);
+
+// 大小写无关比较：32 字节的头名长度，标量 strncasecmp vs 向量化 CaseEq
+static void BM_CaseEqScalar(bench::State &state)
+{
+    static const char A[] = "Access-Control-Request-Headers-X";
+    static const char B[] = "ACCESS-CONTROL-REQUEST-HEADERS-X";
+    size_t hits = 0;
+    for (auto _ : state)
+    {
+        if (SimdScan::CaseEqScalar(A, B, sizeof(A) - 1)) { hits++; }
+    }
+    if (hits == 0) { printf("?"); }
+    state.SetBytesProcessed(state.iterations() * (sizeof(A) - 1));
+}
+BENCHMARK(BM_CaseEqScalar);
+
+static void BM_CaseEqSimd(bench::State &state)
+{
+    static const char A[] = "Access-Control-Request-Headers-X";
+    static const char B[] = "ACCESS-CONTROL-REQUEST-HEADERS-X";
+    size_t hits = 0;
+    for (auto _ : state)
+    {
+        if (SimdScan::CaseEq(A, B, sizeof(A) - 1)) { hits++; }
+    }
+    if (hits == 0) { printf("?"); }
+    state.SetBytesProcessed(state.iterations() * (sizeof(A) - 1));
+}
+BENCHMARK(BM_CaseEqSimd);
+
+// ---------- ResponseBuilder ----------
+
+static void BM_BuildHeader(bench::State &state)
+{
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t total = 0;
+    for (auto _ : state)
+    {
+        total += ResponseBuilder::BuildHeader(header, 200, true, 14235, "text/html");
+    }
+    state.SetBytesProcessed(total);
+}
+BENCHMARK(BM_BuildHeader);
+
+// ---------- TimerWheel ----------
+
+// 1 万个活跃定时器下的 adjust（每个请求到达都会推一次超时）
+static void BM_TimerWheelAdjust(bench::State &state)
+{
+    TimerWheel wheel;
+    const int TIMER_CNT = 10000;
+    for (int i = 1; i <= TIMER_CNT; i++)
+    {
+        wheel.add(i, 60000, []() {});
+    }
+    int id = 1;
+    for (auto _ : state)
+    {
+        wheel.adjust(id, 60000);
+        id = id % TIMER_CNT + 1;
+    }
+}
+BENCHMARK(BM_TimerWheelAdjust);
+
+// ---------- 无锁任务队列 ----------
+
+// 单线程 Push/Pop 往返：测队列本身的开销（不含线程唤醒）
+static void BM_MpmcQueuePushPop(bench::State &state)
+{
+    MpmcQueue<int> queue(4096);
+    int v = 0;
+    for (auto _ : state)
+    {
+        queue.Push(1);
+        queue.Pop(v);
+    }
+}
+BENCHMARK(BM_MpmcQueuePushPop);
+
+// 线程池端到端：提交空任务并等全部执行完（含唤醒和竞争）
+static void BM_ThreadPoolRoundTrip(bench::State &state)
+{
+    ThreadPool pool(4);
+    std::atomic<uint64_t> done{0};
+    for (auto _ : state)
+    {
+        pool.AddTask([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    while (done.load(std::memory_order_relaxed) < state.iterations())
+    {
+        std::this_thread::yield();
+    }
+}
+BENCHMARK(BM_ThreadPoolRoundTrip);
+
+// ---------- 日志 ----------
+
+// 异步日志吞吐：格式化 + 无锁入环（落盘由后台线程异步做）
+static void BM_LogWrite(bench::State &state)
+{
+    static bool inited = false;
+    if (!inited)
+    {
+        Log::Instance()->Init("/tmp/bench_log", ".log", 8192, Log::INFO);
+        inited = true;
+    }
+    for (auto _ : state)
+    {
+        LOG_INFO("bench line %d from %s cost %.3f ms", 42, "127.0.0.1", 1.234);
+    }
+}
+BENCHMARK(BM_LogWrite);
+
+int main(int argc, char *argv[])
+{
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    printf("%-28s %15s %20s\n", "benchmark", "ns/op", "ops/s");
+    return bench::RunAll(filter);
+}
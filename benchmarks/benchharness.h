@@ -0,0 +1,134 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * 极简微基准框架（Google Benchmark 同款用法，零外部依赖）
+ *
+ * 用法：
+ *   static void BM_Foo(bench::State& state) {
+ *       for (auto _ : state) { ...被测代码... }
+ *       state.SetBytesProcessed(state.iterations() * 64);
+ *   }
+ *   BENCHMARK(BM_Foo);
+ *
+ * 框架自动倍增迭代次数直到单轮耗时 ≥ 200ms，再汇报 ns/op、ops/s
+ * 和可选的吞吐（MB/s）。不带统计学花活，够做回归对比就行
+ */
+namespace bench
+{
+
+class State
+{
+public:
+    explicit State(uint64_t iters) : iters_(iters) {}
+
+    // range-for 支持：for (auto _ : state) 恰好执行 iterations 次
+    // （解引用返回带自定义构造的空类型，未使用的 _ 不会触发编译告警）
+    struct Tick
+    {
+        Tick() {}
+        ~Tick() {}
+    };
+    struct Iterator
+    {
+        uint64_t left;
+        bool operator!=(const Iterator &other) const { return left != other.left; }
+        void operator++() { --left; }
+        Tick operator*() const { return Tick(); }
+    };
+    Iterator begin() const { return {iters_}; }
+    Iterator end() const { return {0}; }
+
+    uint64_t iterations() const { return iters_; }
+    void SetBytesProcessed(uint64_t bytes) { bytes_ = bytes; }
+    uint64_t bytesProcessed() const { return bytes_; }
+
+private:
+    uint64_t iters_;
+    uint64_t bytes_ = 0;
+};
+
+using BenchFn = std::function<void(State &)>;
+
+inline std::vector<std::pair<std::string, BenchFn>> &Registry()
+{
+    static std::vector<std::pair<std::string, BenchFn>> registry;
+    return registry;
+}
+
+inline bool Register(const char *name, BenchFn fn)
+{
+    Registry().emplace_back(name, std::move(fn));
+    return true;
+}
+
+// 跑一个基准：迭代数从 1 开始倍增，直到单轮 ≥ 200ms 再计数
+inline void RunOne(const std::string &name, const BenchFn &fn)
+{
+    using Clock = std::chrono::steady_clock;
+    uint64_t iters = 1;
+    double elapsedSec = 0;
+    uint64_t bytes = 0;
+    while (true)
+    {
+        State state(iters);
+        auto t0 = Clock::now();
+        fn(state);
+        auto t1 = Clock::now();
+        elapsedSec = std::chrono::duration<double>(t1 - t0).count();
+        bytes = state.bytesProcessed();
+        if (elapsedSec >= 0.2 || iters >= (1ull << 30))
+        {
+            break;
+        }
+        // 按已测速度直接跳到目标迭代数附近（至少翻倍，避免小样本抖动）
+        uint64_t next = iters * 2;
+        if (elapsedSec > 1e-6)
+        {
+            uint64_t projected = static_cast<uint64_t>(iters * (0.25 / elapsedSec));
+            if (projected > next) { next = projected; }
+        }
+        iters = next;
+    }
+    double nsPerOp = elapsedSec * 1e9 / iters;
+    double opsPerSec = iters / elapsedSec;
+    if (bytes > 0)
+    {
+        double mbps = bytes / elapsedSec / (1024.0 * 1024.0);
+        printf("%-28s %12.1f ns/op %14.0f ops/s %10.1f MB/s\n",
+               name.c_str(), nsPerOp, opsPerSec, mbps);
+    }
+    else
+    {
+        printf("%-28s %12.1f ns/op %14.0f ops/s\n", name.c_str(), nsPerOp, opsPerSec);
+    }
+    fflush(stdout);
+}
+
+// 跑全部（或名字包含 filter 子串的那部分）
+inline int RunAll(const char *filter = nullptr)
+{
+    for (auto &entry : Registry())
+    {
+        if (filter && entry.first.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        RunOne(entry.first, entry.second);
+    }
+    return 0;
+}
+
+} // namespace bench
+
+#define BENCHMARK(fn) \
+    static bool fn##_registered_ = bench::Register(#fn, fn)
+
+#endif // BENCH_HARNESS_H
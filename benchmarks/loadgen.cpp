@@ -0,0 +1,272 @@
+/**
+ * 回环压测器：对一个已启动的 server 实例打 HTTP 负载并汇报
+ * RPS + p50/p99/p999 延迟
+ *
+ * 用法：
+ *   loadgen [-h host] [-P port] [-c connections] [-d seconds]
+ *           [-p pipeline] [-n] [-u path]
+ *   -c  并发连接数（默认 64）
+ *   -d  压测时长秒（默认 10）
+ *   -p  流水线深度：每连接一次写出几个请求（默认 1）
+ *   -n  关闭 keep-alive：每个响应后断开重连（测连接建立路径）
+ *   -u  请求路径（默认 /index.html）
+ *
+ * 单线程 epoll 客户端：发送时间戳入队、响应按 Content-Length 切分后
+ * 出队算延迟，所以流水线模式下每个请求的延迟也是准的
+ */
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static uint64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct Config
+{
+    const char *host = "127.0.0.1";
+    int port = 1316;
+    int connections = 64;
+    int durationSec = 10;
+    int pipeline = 1;
+    bool keepAlive = true;
+    const char *path = "/index.html";
+};
+
+// 每条连接的收发状态
+struct Conn
+{
+    int fd = -1;
+    size_t sendOff = 0;            // 请求块已写出的字节数
+    std::deque<uint64_t> sendTs;   // 每个在途请求的发出时间戳
+    // 响应切分状态机
+    std::string headerBuf;         // 未凑齐的响应头字节
+    bool inBody = false;
+    size_t bodyLeft = 0;           // 当前响应体还差多少字节
+};
+
+static int ConnectNonBlock(const Config &cfg)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) { return -1; }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, cfg.host, &addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+// 消费收到的字节，返回本次切出的完整响应数
+static int ConsumeResponse(Conn &conn, const char *data, size_t len,
+                           std::vector<uint64_t> &latencies)
+{
+    int finished = 0;
+    size_t off = 0;
+    while (off < len)
+    {
+        if (conn.inBody)
+        {
+            size_t take = std::min(conn.bodyLeft, len - off);
+            conn.bodyLeft -= take;
+            off += take;
+            if (conn.bodyLeft == 0)
+            {
+                conn.inBody = false;
+                finished++;
+                if (!conn.sendTs.empty())
+                {
+                    latencies.push_back(NowUs() - conn.sendTs.front());
+                    conn.sendTs.pop_front();
+                }
+            }
+            continue;
+        }
+        // 攒响应头直到空行，再抠出 Content-Length
+        conn.headerBuf.append(data + off, len - off);
+        size_t headEnd = conn.headerBuf.find("\r\n\r\n");
+        if (headEnd == std::string::npos)
+        {
+            return finished; // 头还没收全
+        }
+        size_t contentLen = 0;
+        size_t clPos = conn.headerBuf.find("Content-Length:");
+        if (clPos != std::string::npos && clPos < headEnd)
+        {
+            contentLen = strtoul(conn.headerBuf.c_str() + clPos + 15, nullptr, 10);
+        }
+        // 头部之后可能已经跟着一段体：把多收的字节退回主循环
+        size_t consumedFromData = (len - off) - (conn.headerBuf.size() - headEnd - 4);
+        off += consumedFromData;
+        conn.headerBuf.clear();
+        conn.inBody = true;
+        conn.bodyLeft = contentLen;
+        if (contentLen == 0)
+        {
+            conn.inBody = false;
+            finished++;
+            if (!conn.sendTs.empty())
+            {
+                latencies.push_back(NowUs() - conn.sendTs.front());
+                conn.sendTs.pop_front();
+            }
+        }
+    }
+    return finished;
+}
+
+int main(int argc, char *argv[])
+{
+    Config cfg;
+    int opt;
+    while ((opt = getopt(argc, argv, "h:P:c:d:p:nu:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'h': cfg.host = optarg; break;
+            case 'P': cfg.port = atoi(optarg); break;
+            case 'c': cfg.connections = atoi(optarg); break;
+            case 'd': cfg.durationSec = atoi(optarg); break;
+            case 'p': cfg.pipeline = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            case 'n': cfg.keepAlive = false; break;
+            case 'u': cfg.path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-h host] [-P port] [-c conns] [-d sec] "
+                                "[-p pipeline] [-n] [-u path]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // 预拼好请求块：pipeline 个请求一次写出
+    char oneReq[512];
+    int oneLen = snprintf(oneReq, sizeof(oneReq),
+                          "GET %s HTTP/1.1\r\nHost: %s:%d\r\nConnection: %s\r\n\r\n",
+                          cfg.path, cfg.host, cfg.port,
+                          cfg.keepAlive ? "keep-alive" : "close");
+    std::string reqBlock;
+    for (int i = 0; i < cfg.pipeline; i++) { reqBlock.append(oneReq, oneLen); }
+
+    int epfd = epoll_create1(0);
+    std::vector<Conn> conns(cfg.connections);
+    for (int i = 0; i < cfg.connections; i++)
+    {
+        conns[i].fd = ConnectNonBlock(cfg);
+        if (conns[i].fd < 0)
+        {
+            fprintf(stderr, "connect failed: %s\n", strerror(errno));
+            return 1;
+        }
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.u32 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(1 << 20);
+    uint64_t completed = 0;
+    uint64_t startUs = NowUs();
+    uint64_t deadlineUs = startUs + (uint64_t)cfg.durationSec * 1000000;
+    char recvBuf[64 * 1024];
+    std::vector<struct epoll_event> events(cfg.connections);
+
+    while (NowUs() < deadlineUs)
+    {
+        int n = epoll_wait(epfd, events.data(), events.size(), 100);
+        for (int i = 0; i < n; i++)
+        {
+            Conn &conn = conns[events[i].data.u32];
+            if (events[i].events & EPOLLOUT)
+            {
+                // 没有在途请求时写出下一个请求块（每个请求入一个时间戳）
+                if (conn.sendTs.empty() && conn.sendOff == 0)
+                {
+                    for (int k = 0; k < cfg.pipeline; k++) { conn.sendTs.push_back(NowUs()); }
+                }
+                while (conn.sendOff < reqBlock.size())
+                {
+                    ssize_t wn = write(conn.fd, reqBlock.data() + conn.sendOff,
+                                       reqBlock.size() - conn.sendOff);
+                    if (wn <= 0) { break; }
+                    conn.sendOff += wn;
+                }
+                if (conn.sendOff >= reqBlock.size())
+                {
+                    // 请求全发出去了：改成只等响应
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN;
+                    ev.data.u32 = events[i].data.u32;
+                    epoll_ctl(epfd, EPOLL_CTL_MOD, conn.fd, &ev);
+                }
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                ssize_t rn;
+                while ((rn = read(conn.fd, recvBuf, sizeof(recvBuf))) > 0)
+                {
+                    completed += ConsumeResponse(conn, recvBuf, rn, latencies);
+                }
+                bool closed = (rn == 0) || (events[i].events & (EPOLLHUP | EPOLLERR));
+                // 本块响应齐了（或对端关了）：重新开始下一块
+                if (conn.sendTs.empty() || closed)
+                {
+                    if (!cfg.keepAlive || closed)
+                    {
+                        epoll_ctl(epfd, EPOLL_CTL_DEL, conn.fd, nullptr);
+                        close(conn.fd);
+                        conn = Conn();
+                        conn.fd = ConnectNonBlock(cfg);
+                        if (conn.fd < 0) { continue; }
+                    }
+                    conn.sendOff = 0;
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN | EPOLLOUT;
+                    ev.data.u32 = events[i].data.u32;
+                    epoll_ctl(epfd, cfg.keepAlive && !closed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                              conn.fd, &ev);
+                }
+            }
+        }
+    }
+
+    double elapsedSec = (NowUs() - startUs) / 1e6;
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) -> uint64_t {
+        if (latencies.empty()) { return 0; }
+        size_t idx = (size_t)(p * (latencies.size() - 1));
+        return latencies[idx];
+    };
+    printf("connections: %d  pipeline: %d  keep-alive: %s  duration: %.1fs\n",
+           cfg.connections, cfg.pipeline, cfg.keepAlive ? "on" : "off", elapsedSec);
+    printf("requests: %llu  RPS: %.0f\n",
+           (unsigned long long)completed, completed / elapsedSec);
+    printf("latency p50: %lluus  p99: %lluus  p999: %lluus\n",
+           (unsigned long long)pct(0.50), (unsigned long long)pct(0.99),
+           (unsigned long long)pct(0.999));
+    return 0;
+}
@@ -7,32 +7,146 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <cassert>
 
 class AIEngine {
 public:
+    // 会话配置：从服务器配置传入，不再把线程数硬编码在引擎里
+    // 🌟 面试亮点：session 池（N 个会话共享同一 Ort::Env / 同一份模型权重）
+    // 单个 Ort::Session 串行 Run 最多吃满一个核，N 个会话 + N 条攒批线程
+    // 才能把多核推理机真正跑起来
+    struct ModelOptions {
+        int sessionNum = 1;       // session 池大小（= 攒批线程数）
+        int intraOpThreads = 1;   // 单算子内部并行度
+        int interOpThreads = 1;   // 图内算子间并行度
+        // 图优化级别：0=关 1=basic 2=extended 其余=ALL
+        int graphOptLevel = 99;
+    };
+
     // 单例模式，保证全局只有一个推理引擎和模型驻留内存
     static AIEngine* Instance();
 
-    // 加载 ONNX 模型
+    // 加载 ONNX 模型（成功后启动攒批推理线程）
+    // 不带 opts 的重载用默认配置（类内默认成员初始化不能当默认实参用）
     bool LoadModel(const std::string& modelPath);
+    bool LoadModel(const std::string& modelPath, const ModelOptions& opts);
 
     // 执行推理 (假设我们的模型输入是一维 float 数组，输出也是一维 float 数组)
+    // 🌟 面试亮点：微批 (micro-batching) 推理
+    // 调用方把输入丢进队列拿到 future；专职推理线程每隔一个攒批窗口
+    // 把队列里的请求拼成一个 [batch, width] 张量，一次 Run 吞掉整批，
+    // 并发请求不再在一把大锁上排队串行推理
     std::vector<float> Predict(const std::vector<float>& inputData);
 
+    // 缓存 TTL（秒）：模型重载后旧结果最多再活这么久
+    void SetCacheTTL(int seconds) { cacheTtlUs_ = (uint64_t)seconds * 1000000; }
+
+    // 模型是否已加载就绪（启动期预热逻辑据此决定要不要跑空推理）
+    bool IsLoaded() const { return loaded_; }
+
+    // session 池借还（攒批线程经 AISessionRAII 使用，外部一般不直接调）
+    Ort::Session* GetSession();
+    void FreeSession(Ort::Session* sess);
+
 private:
     AIEngine();
     ~AIEngine();
 
-    // ONNX Runtime 环境与会话
+    // 攒批推理线程主循环
+    void BatchLoop_();
+
+    // 真正跑一次 session：输入已拼成 [batch, width]，session 由调用方借出
+    std::vector<float> RunSession_(Ort::Session* sess, const std::vector<float>& flatInput,
+                                   int64_t batch, int64_t width);
+
+    // 一个排队中的推理请求
+    struct PendingJob {
+        std::vector<float> input;
+        std::promise<std::vector<float>> promise;
+    };
+
+    // 🌟 面试亮点：推理结果缓存（分片 LRU + TTL）
+    // 预测流量高度偏斜（约 70% 的输入是重复的小集合），命中时整条
+    // session_->Run 都省掉。键是量化后的输入向量（1e-3 精度取整），
+    // 分片锁让缓存本身不会变成新的全局争抢点
+    struct PredictCache {
+        static constexpr int SHARD_CNT = 8;          // 分片数（2 的幂）
+        static constexpr size_t MAX_PER_SHARD = 1024; // 每分片条目上限
+
+        struct Entry {
+            std::vector<float> output;
+            uint64_t expireUs; // 过期时刻（单调钟，微秒）
+        };
+        struct Shard {
+            std::mutex mtx;
+            std::list<std::pair<std::string, Entry>> lru; // 头部最热
+            std::unordered_map<std::string,
+                std::list<std::pair<std::string, Entry>>::iterator> index;
+        };
+        Shard shards[SHARD_CNT];
+
+        bool Get(const std::string& key, std::vector<float>& out); // 命中返回 true
+        void Put(const std::string& key, const std::vector<float>& out, uint64_t ttlUs);
+    };
+
+    // 输入向量量化成缓存键（浮点噪声不该打散缓存命中）
+    static std::string CacheKey_(const std::vector<float>& input);
+
+    // ONNX Runtime 环境与会话池
     std::unique_ptr<Ort::Env> env_;
-    std::unique_ptr<Ort::Session> session_;
+    std::vector<std::unique_ptr<Ort::Session>> sessions_; // 池内所有会话（共享 env_ 里的权重）
+    std::vector<Ort::Session*> freeSessions_;             // 空闲会话栈
+    std::mutex sessMtx_;                                  // 保护空闲栈
+    std::condition_variable sessCond_;                    // 池空时等待归还
+    std::atomic<bool> loaded_{false};                     // 模型是否已就绪
     Ort::MemoryInfo memoryInfo_;
 
     // 模型的输入输出节点信息
     std::vector<const char*> inputNodeNames_;
     std::vector<const char*> outputNodeNames_;
-    
-    std::mutex mtx_; // 保证推理过程的线程安全
+
+    // 攒批队列与推理线程（每个 session 配一条攒批线程，各自出批并发 Run）
+    std::deque<PendingJob> jobQueue_;
+    std::mutex qmtx_;                // 保护 jobQueue_
+    std::condition_variable jobCond_;
+    std::vector<std::thread> batchThreads_;
+    std::atomic<bool> stop_{false};
+
+    int batchWindowUs_ = 200; // 攒批窗口（微秒）：延迟预算，等并发请求"凑上车"
+    size_t maxBatch_ = 32;    // 单批最大请求数
+
+    // 推理结果缓存
+    PredictCache cache_;
+    uint64_t cacheTtlUs_ = 60ull * 1000000; // 默认 TTL 60 秒
+};
+
+// RAII 借还推理会话（和 SqlConnRAII 一个套路）
+class AISessionRAII
+{
+public:
+    // 构造函数：传入一个 Session 指针的引用，会自动赋值
+    AISessionRAII(Ort::Session **sess, AIEngine *engine) {
+        assert(engine);
+        *sess = engine->GetSession(); // 借出会话
+        sess_ = *sess;
+        engine_ = engine;
+    }
+    // 析构函数：自动归还会话
+    ~AISessionRAII() {
+        if(sess_) {
+            engine_->FreeSession(sess_);
+        }
+    }
+private:
+    Ort::Session *sess_;  // 当前会话
+    AIEngine *engine_;    // 推理引擎
 };
 
-#endif // AI_ENGINE_H
\ No newline at end of file
+#endif // AI_ENGINE_H
@@ -7,23 +7,26 @@
 #include <iostream>
 #include <unistd.h>  // 包含 read, write 系统调用
 #include <sys/uio.h> // 包含 readv (这是面试亮点)
+#include "bufferpool.h" // 🌟 存储改从中央缓冲块池借用
 using namespace std;
 // ... 这里我们将写入类定义 ...
 
 class Buffer
 {
 private:
-    char *BeginPtr_(); // 获取缓冲区起始位置的指针(// 返回 buffer 内部 vector 的起始指针 (这是一个辅助私有函数)
+    char *BeginPtr_(); // 获取缓冲区起始位置的指针 (这是一个辅助私有函数)
 
     const char *BeginPtr_() const; // const 版本，供只读操作使用
 
-    void MakeSpace_(size_t len); // 确保缓冲区有足够的空间存储 len 字节的数据(核心函数：当空间不够时，用来扩展空间或整理内存)
+    void MakeSpace_(size_t len); // 确保缓冲区有足够的空间存储 len 字节的数据(核心函数：当空间不够时，用来换大块或整理内存)
 
-    // 成员变量
-    vector<char> buffer_;// 用于存储数据的缓冲区
+    // 🌟 成员变量：不再是自管理的 vector<char>，而是从 BufferPool 借来的分级块
+    // （懒借用：连接空闲时 data_ 可以为空，一个字节都不占）
+    char *data_;    // 当前借用的块，可能为 nullptr
+    size_t cap_;    // 当前块的容量
     atomic<size_t> readPos_;// 读指针，表示下一个可读字节的位置
     atomic<size_t> writePos_;// 写指针，表示下一个可写字节的位置
-   
+
 public:
 
     // 构造函数，允许指定初始缓冲区大小，默认为1024字节
@@ -47,9 +50,12 @@ public:
     // 读取直到某个指针位置 (用于解析 HTTP 行)
     void RetrieveUntil(const char *end);
 
-    // 清空缓冲区 (重置 readPos_ = writePos_ = 0)
+    // 清空缓冲区 (重置 readPos_ = writePos_ = 0；长出来的大块顺手还给池子)
     void RetrieveAll();
 
+    // 彻底释放存储：把借用的块还给池子（空闲连接收缩用）
+    void Shrink();
+
     // 获取所有可读数据，并转换为字符串
     string RetrieveAllToStr();
 
@@ -75,13 +81,20 @@ public:
     // 写入另一个 Buffer 的数据
     void Append(const Buffer &buff);
 
-    // 从 fd 读取数据 (利用 readv)
-    ssize_t ReadFd(int fd, int *Errno);
+    // 从 fd 读取数据：按 hint 预留空间后一次 read 直读进缓冲区
+    // 🌟 自适应读窗口：hint 是调用方观测到的流量尺寸（HttpConn 按最近
+    // 读量动态调整）。大上传直读进 64K 块，彻底绕开"暂存块 + Append
+    // 再拷一次"的双拷贝；小请求只借 4K 块，不浪费 readv 装配开销
+    ssize_t ReadFd(int fd, int *Errno, size_t hint = 65536);
 
     // 向 fd 写入数据
     ssize_t WriteFd(int fd, int *Errno);
 
-    // 析构函数
-    ~Buffer() = default;
+    // 禁止拷贝：data_ 是裸借用指针，拷贝会导致双重归还
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    // 析构函数：把借用的块还给池子
+    ~Buffer();
 };
 #endif // BUFFER_H
\ No newline at end of file
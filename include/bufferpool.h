@@ -0,0 +1,43 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <mutex>
+#include <vector>
+#include <stddef.h>
+
+// 🌟 面试亮点：按大小分级的中央缓冲块池（4K / 16K / 64K）
+// 每个 HttpConn 的两个 Buffer 不再各自持有只增不减的 vector<char>，
+// 而是从这里借块、用完归还：5 万连接下冷缓冲的常驻内存被免费链表
+// 上限封顶，且预热后的借还就是一次链表 pop/push，热路径零 malloc。
+// 超过 64K 的罕见大块直接走 new[]，不进池子
+class BufferPool
+{
+public:
+    static BufferPool *Instance(); // 单例模式
+
+    // 借一块容量 ≥ need 的内存，实际容量写回 *cap
+    char *Acquire(size_t need, size_t *cap);
+
+    // 归还（cap 必须是 Acquire 返回的容量，用于定位大小级）
+    void Release(char *chunk, size_t cap);
+
+    // 启动期预热：每个大小级预先分配 chunksPerClass 块（不超过 MAX_FREE）
+    // 并逐页写一遍，把缺页异常提前到 boot 阶段付掉——首波流量的借块
+    // 就是纯链表 pop，不再踩 malloc + 页错误
+    void Prewarm(size_t chunksPerClass);
+
+    static constexpr int CLASS_CNT = 3;
+    static const size_t CLASS_SIZE[CLASS_CNT]; // 各级块大小：4K/16K/64K
+    static const size_t MAX_FREE[CLASS_CNT];   // 各级空闲链表的块数上限（封顶常驻内存）
+
+private:
+    BufferPool() = default;
+    ~BufferPool();
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // 每个大小级一把锁 + 一条空闲链表：不同级之间借还互不争抢
+    std::mutex mtx_[CLASS_CNT];
+    std::vector<char *> free_[CLASS_CNT];
+};
+#endif // BUFFERPOOL_H
@@ -0,0 +1,26 @@
+#ifndef FDPASS_H
+#define FDPASS_H
+
+#include <vector>
+
+// 🌟 面试亮点：unix socket 文件描述符传递（SCM_RIGHTS）
+// 零停机热升级的核心：老进程在 drain 开始时把所有分片的监听 socket
+// 经 sendmsg 的辅助数据递给新 exec 的二进制。SCM_RIGHTS 复制的是内核
+// 文件描述——新老进程共享同一个 accept 队列，握手中的连接一个不丢，
+// 新进程立刻开始 accept，老进程安心送完手头的连接再退出
+class FdPass
+{
+public:
+    // 单次最多传递的 fd 数（分片数的合理上限）
+    static const int MAX_FDS = 16;
+
+    // 发送端（老进程）：在 path 上建 unix 监听 socket，等一个接收方
+    // 连上来后把 fds 整批递过去。timeoutMS 内没人来取返回 false
+    static bool Send(const char *path, const std::vector<int> &fds, int timeoutMS);
+
+    // 接收端（新进程）：连接 path 并收取 fd。没有发送方在等（socket
+    // 文件不存在/没人监听）返回 false——正常冷启动就走这条路
+    static bool Recv(const char *path, std::vector<int> &fds);
+};
+
+#endif // FDPASS_H
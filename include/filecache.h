@@ -0,0 +1,107 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ctime>
+
+/*
+ * 静态文件缓存 (进程级单例)
+ *
+ * 职责：按路径缓存已打开的文件 fd 和 stat 信息，供 sendfile 发送路径复用。
+ * 热点文件反复访问时，省掉每请求一次的 stat + open + close 三个系统调用。
+ *
+ * 设计亮点：
+ * 1. 引用计数句柄 (shared_ptr + 自定义析构)：连接持有 Handle 期间 fd 不会被关，
+ *    被 LRU 淘汰的条目等最后一个使用者释放后才真正 close
+ * 2. LRU 淘汰：按缓存文件总字节数设上限，超出时从最久未用的条目开始踢
+ * 3. mtime 失效：命中后每秒最多重新 stat 一次，文件被改过就作废重开
+ */
+class FileCache
+{
+public:
+    // 🌟 预压缩变体：同一个文件的 gzip / brotli 压缩副本
+    // "压一次、发无数次"——压缩成本只在首次请求时付一回，之后直接发缓存字节
+    enum Encoding
+    {
+        GZIP = 0,
+        BR = 1,
+        ENCODING_CNT
+    };
+
+    // 缓存条目：一个打开的文件
+    struct Entry
+    {
+        std::string path;      // 文件路径（缓存 key）
+        int fd = -1;           // 打开的文件描述符
+        struct stat st;        // 记忆化的 stat 结果
+        time_t lastCheck = 0;  // 上次 mtime 校验的时间（秒）
+
+        // 【修正】本条目计入 totalBytes_ 的字节数：st_size + 已构建变体之和。
+        // 淘汰/失效时必须按这个数回退——只退 st_size 会把变体字节永久
+        // 漏在账上，totalBytes_ 只涨不跌，最后缓存被榨成空转
+        size_t charged = 0;
+
+        // 预压缩变体（懒构建）：shared_ptr 让发送中的连接不受条目失效影响
+        std::shared_ptr<std::vector<char>> variants[ENCODING_CNT];
+        bool variantFailed[ENCODING_CNT] = {false, false}; // 压缩无收益/失败就别再试了
+
+        ~Entry(); // 最后一个引用释放时关闭 fd
+    };
+
+    /* RAII 句柄：持有期间保证 fd 有效，析构自动减引用 */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        explicit Handle(std::shared_ptr<Entry> entry) : entry_(std::move(entry)) {}
+
+        bool Valid() const { return entry_ != nullptr; }
+        int Fd() const { return entry_ ? entry_->fd : -1; }
+        const struct stat &Stat() const { return entry_->st; }
+        void Release() { entry_.reset(); }
+        const std::shared_ptr<Entry> &Raw() const { return entry_; }
+
+    private:
+        std::shared_ptr<Entry> entry_;
+    };
+
+    static FileCache *Instance(); // 单例模式，获取唯一实例
+
+    // 按路径取句柄；文件不存在 / 是目录 / 打不开时返回无效句柄
+    Handle Get(const std::string &path);
+
+    // 取（必要时懒构建）某个编码的预压缩变体；不划算或失败返回 nullptr
+    std::shared_ptr<std::vector<char>> GetVariant(const Handle &handle, Encoding enc);
+
+    // 设置缓存总字节数上限（超出按 LRU 淘汰）
+    void SetCapacity(size_t maxBytes);
+
+private:
+    FileCache() = default;
+    ~FileCache() = default;
+
+    // 打开文件并建立缓存条目（调用方持锁）
+    std::shared_ptr<Entry> OpenEntry_(const std::string &path);
+    // 把超出容量的冷条目踢出去（调用方持锁）
+    void Evict_();
+    // 从 fd 读出整个文件并压缩，成功返回压缩字节（锁外执行，压缩很贵）
+    static std::shared_ptr<std::vector<char>> Compress_(const Entry &entry, Encoding enc);
+
+    static const size_t MAX_COMPRESS_BYTES = 8 * 1024 * 1024; // 超过 8MB 的文件不做预压缩
+
+    size_t maxBytes_ = 64 * 1024 * 1024; // 默认缓存上限 64MB
+    size_t totalBytes_ = 0;              // 当前缓存的文件总字节数
+
+    // LRU: 链表头是最近使用，尾是最久未用；map 指向链表节点
+    std::list<std::shared_ptr<Entry>> lru_;
+    std::unordered_map<std::string, std::list<std::shared_ptr<Entry>>::iterator> cache_;
+    std::mutex mtx_; // 保护以上结构
+};
+
+#endif // FILE_CACHE_H
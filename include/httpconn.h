@@ -12,6 +12,8 @@
 
 #include "buffer.h"
 #include "sqlconnpool.h"
+#include "filecache.h"
+#include "router.h"
 
 
 // 每一个连上来的客户端，都会分配一个 HttpConn 对象
@@ -24,29 +26,106 @@ private:
 
     // 🌟 面试亮点：分散写 (Scatter/Gather IO)
     int iovCnt_;
-    struct iovec iov_[2]; // iov_[0]存HTTP响应头，iov_[1]存具体的网页文件
+    struct iovec iov_[2]; // iov_[0]存HTTP响应头（文件体走 sendfile，不再占 iov_[1]）
 
     Buffer readBuff_;  // 读缓冲区
     Buffer writeBuff_; // 写缓冲区
 
     // -- HTTP 请求相关的状态变量 --
     bool isKeepAlive_;
+    bool acceptGzip_; // 客户端 Accept-Encoding 是否带 gzip
+    bool acceptBr_;   // 客户端 Accept-Encoding 是否带 br
     std::string method_;  // GET / POST
     std::string path_;    // 请求路径，如 /index.html
     std::string version_; // 协议版本，如 HTTP/1.1
     std::string body_;    // POST 的请求体
-
-    // 内部处理函数：解析 HTTP 请求 (简易状态机)
-    bool ParseRequestLine_(const std::string &line); // 解析请求行
-    void ParseHeader_(const std::string &line);      // 解析请求头
-    void ParseBody_(const std::string &line);        // 解析请求体
-
+    size_t contentLength_; // Content-Length 声明的体长度（0 表示无体）
+
+    // 🌟 Range 请求（媒体播放器拖进度条）：bytes=S-E / bytes=S- / bytes=-N
+    // rangeStart_ == SIZE_MAX 表示后缀形式（取末尾 rangeEnd_ 字节），
+    // rangeEnd_ == SIZE_MAX 表示开区间（S 到文件末尾）
+    bool hasRange_;
+    size_t rangeStart_;
+    size_t rangeEnd_;
+
+    // 🌟 面试亮点：增量式状态机解析器（零拷贝）
+    // 直接在 readBuff_ 上逐行推进，解析状态跨多次 Read 保留，
+    // 半包时返回"还差数据"，不再整包 RetrieveAllToStr 拷贝 + 正则
+    enum ParseState
+    {
+        REQUEST_LINE, // 正在解析请求行
+        HEADERS,      // 正在解析请求头
+        BODY,         // 正在接收请求体
+        FINISH        // 一个完整请求解析完毕
+    };
+    ParseState parseState_;
+
+    // 内部处理函数：解析 HTTP 请求 (增量状态机)
+    bool ParseFromBuffer_();                              // 驱动状态机，返回是否凑齐一个完整请求
+    bool ParseRequestLine_(const char *begin, const char *end); // 解析请求行
+    bool ParseHeaderLine_(const char *begin, const char *end);  // 解析单行请求头，空行返回 false 表示头部结束
+    void ResetParse_();                                   // 为下一个请求复位状态机
+
+    // 内部处理函数：按路由表分发一个解析完毕的请求，响应追加进 writeBuff_
+    void HandleRequest_();
+
+    // 路由处理函数（启动期经 RegisterRoutes 注册进 Router）
+    void HandleMetrics_(); // GET  /metrics     监控端点
+    void HandlePredict_(); // POST /api/predict AI 推理接口
+    void HandleLogin_();   // POST /login       登录（预编译语句查库）
+    void HandleHealth_();  // GET  /healthz     LB 健康检查（预热完成前返回 503）
     // 内部处理函数：生成 HTTP 响应
     void MakeResponse_();
 
-    // 🌟 面试亮点：零拷贝之 mmap 内存映射
-    char *file_;           // 指向 mmap 映射到内存中的文件首地址
-    struct stat fileStat_; // 请求文件的状态信息 (大小、是否存在等)
+    // 🌟 面试亮点：零拷贝之 sendfile
+    // 文件不再 mmap 进用户空间：响应头用 writev 发出，文件体由内核直接
+    // 从页缓存送进 socket（sendfile），省掉每请求一对 mmap/munmap 和 TLB 抖动
+    void SetCork_(bool on);  // TCP_CORK 开关：把响应头和文件体攒成整包发出
+    FileCache::Handle fileHandle_; // 文件缓存句柄：持有期间 fd 有效（fd 归缓存所有）
+    std::shared_ptr<std::vector<char>> bodyData_; // 内存响应体（预压缩变体），走 iov_[1] 发送
+    int fileFd_;             // 正在发送的文件 fd（-1 表示无文件体）
+    off_t fileOff_;          // sendfile 的文件偏移（内核推进）
+    size_t fileLen_;         // 文件体还剩多少字节没发
+    struct stat fileStat_;   // 请求文件的状态信息 (大小、是否存在等)
+
+    // 🌟 自适应读窗口：按最近的读量调 ReadFd 的预留空间。读满窗口
+    // 说明是大流量（上传），窗口翻倍直到 64K 直读；远读不满则折半
+    // 退回 4K——小的 keep-alive 请求不再为用不上的大块买单
+    static const size_t READ_HINT_MIN = 4096;
+    static const size_t READ_HINT_MAX = 64 * 1024;
+    size_t readHint_;
+
+    // 【新增】延迟打点：读完成时刻（微秒），写完成时上报整请求延迟直方图
+    uint64_t readDoneUs_;
+    // 【新增】最近一次读/写活动时刻（微秒），空闲收缩扫描用
+    uint64_t lastActiveUs_;
+    // 【修正】调度在途标记：从事件派发进线程池到 reactor 重新武装 fd
+    // 之间为 true。只在 reactor 线程读写（派发点置位、DrainOps_ 重武装
+    // /关闭时清零），所以不用原子。空闲收缩扫描必须据此跳过——
+    // lastActiveUs_ 只在任务内部更新，事件刚出队、worker 还没跑到
+    // Read() 时它还是旧值，光看它会在 worker 写缓冲的同时把块还给池子
+    bool inFlight_;
+    // 【新增】泊车的 DB 绑定处理函数：Process() 遇到 DB 路由时不在 worker 上
+    // 执行，存在这里等专职 DB 线程经 RunPendingDb() 完成
+    Router::Handler pendingDbHandler_;
+
+    // 🌟 抽样分段追踪：1/64 的读事件在出队时被 TraceArm 选中，之后在
+    // 四个固定点打 TSC 戳（任务开始/解析完成/响应组装完成/末字节写出），
+    // 写完成时整条拆成四段上报 per-stage 直方图。未抽中的请求在每个
+    // 打点处只付一次 active 判断——常开着进生产没有负担
+    struct TraceRec
+    {
+        bool active = false;
+        uint64_t deqTsc = 0;   // 事件出队（DealRead_，reactor 线程）
+        uint64_t taskTsc = 0;  // worker 任务开始（Read 入口）
+        uint64_t parseTsc = 0; // 解析完成（状态机凑齐完整请求）
+        uint64_t builtTsc = 0; // 响应组装完成（iov 就位）
+    };
+    TraceRec trace_;
+    void TraceFlush_(); // 末字节写出：四段差值换算微秒上报后熄火
+
+    // Process() 出口和 RunPendingDb() 共用：把攒好的响应装进 iov
+    void FinishResponse_();
 public:
     // 安全限制
     static const size_t MAX_REQUEST_BODY_SIZE = 1 << 20;  // 1MB 最大请求体
@@ -54,6 +133,9 @@ public:
     HttpConn() ;
     ~HttpConn() ;
 
+    // 启动期调用一次：把所有 API 端点注册进 Router（静态文件是默认路由）
+    static void RegisterRoutes();
+
     // 初始化连接 (记录 fd 和 客户端 IP 地址)
     void Init(int fd, const sockaddr_in &addr);
     // 关闭连接
@@ -67,20 +149,46 @@ public:
     // 处理请求 (解析 HTTP 请求，生成响应)
     bool Process();
 
+    // 调度在途标记（只在 reactor 线程上调用，见 inFlight_ 注释）
+    void SetInFlight(bool v) { inFlight_ = v; }
+
+    // 🌟 抽样追踪入口：reactor 在事件出队时抽中本请求（1/N），带上
+    // 出队时刻的 TSC 戳；后续各阶段打点由连接自己完成
+    void TraceArm(uint64_t deqTsc)
+    {
+        trace_.active = true;
+        trace_.deqTsc = deqTsc;
+        trace_.taskTsc = trace_.parseTsc = trace_.builtTsc = 0;
+    }
+
+    // 🌟 DB 泊车接口：Process() 碰到 DB 绑定路由时存下处理函数并返回，
+    // 由 WebServer 把连接交给专职 DB 线程池；RunPendingDb() 在 DB 线程上
+    // 完成数据库往返和响应组装
+    bool HasPendingDb() const { return pendingDbHandler_ != nullptr; }
+    void RunPendingDb();
+
     // 一些get方法
     int GetFd() const;
     int GetPort() const;
     const char *GetIP() const;
     sockaddr_in GetAddr() const;
 
-    //// 还需要写多少字节的数据
-    int ToWriteBytes() { return iov_[0].iov_len + iov_[1].iov_len; }
+    //// 还需要写多少字节的数据（响应头 + 内存响应体 + 未发完的文件体）
+    size_t ToWriteBytes() { return iov_[0].iov_len + iov_[1].iov_len + fileLen_; }
     //是否保持长连接
     bool IsKeepAlive() const { return isKeepAlive_; }
 
+    // 🌟 空闲内存回收：连接空闲超过 idleUs 且没有在途响应时，把读写缓冲的
+    // 块还给 BufferPool、收掉请求体 string 的容量。连接本身保持打开，
+    // 下次请求到来时缓冲按需重新借块——RSS 跟随活跃负载而不是峰值负载
+    void ShrinkIfIdle(uint64_t nowUs, uint64_t idleUs);
+
     //静态全局变量
     static std::atomic<int> userCount_; // 统计当前在线用户数量
     static const char *srcDir_;          // 网站根目录
     static bool isET;                 // 是否是边缘触发模式
+    // 【新增】预热完成标志：WebServer 构造函数跑完 warm-start 阶段才置 true，
+    // /healthz 在此之前一律 503——LB 故障切换的流量只会打到已预热的进程
+    static std::atomic<bool> serverWarm_;
 };
 #endif // HTTP_CONN_H
\ No newline at end of file
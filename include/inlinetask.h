@@ -0,0 +1,126 @@
+#ifndef INLINE_TASK_H
+#define INLINE_TASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * 🌟 面试亮点：定容无分配任务类型（热路径上的 std::function 替代品）
+ *
+ * std::function 的小对象优化只有 16 字节左右，[this, r, client] 这种
+ * 捕获就会溢出到堆上——10 万事件/秒时每个事件一对 malloc/free，
+ * 分配器直接在 perf 里冒头。InlineTask 把闭包就地构造在 56 字节的
+ * 内联存储里（加操作表指针正好一条缓存行），移动只做一次就地搬运，
+ * 容量不够直接编译期报错（static_assert），永远不会悄悄退化成堆分配。
+ *
+ * 额外带一个时间戳字段：任务队列等待时间的抽样打点不再需要
+ * 包一层捕获闭包的闭包（那会把任何任务都撑爆内联容量）
+ */
+class InlineTask
+{
+public:
+    static constexpr size_t STORAGE_SIZE = 56; // 闭包容量：+ 操作表指针 = 一条缓存行
+
+    InlineTask() noexcept : ops_(nullptr), stampUs_(0) {}
+
+    // 从任意可调用对象构造：闭包就地放进内联存储，超容量编译期拦下
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, InlineTask>::value>::type>
+    InlineTask(F&& f) : stampUs_(0)
+    {
+        using Fn = typename std::decay<F>::type;
+        static_assert(sizeof(Fn) <= STORAGE_SIZE,
+                      "InlineTask: capture too large, would spill to heap -- shrink the lambda");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t),
+                      "InlineTask: over-aligned capture not supported");
+        new (storage_) Fn(std::forward<F>(f));
+        ops_ = &OpsFor_<Fn>::ops;
+    }
+
+    InlineTask(InlineTask&& other) noexcept : ops_(other.ops_), stampUs_(other.stampUs_)
+    {
+        if (ops_)
+        {
+            ops_->relocate(other.storage_, storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset_();
+            ops_ = other.ops_;
+            stampUs_ = other.stampUs_;
+            if (ops_)
+            {
+                ops_->relocate(other.storage_, storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask() { Reset_(); }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 队列等待时间抽样打点（0 = 未抽样）
+    void SetStamp(uint64_t us) noexcept { stampUs_ = us; }
+    uint64_t Stamp() const noexcept { return stampUs_; }
+
+private:
+    // 手写三函数"虚表"：调用 / 就地搬运 / 析构
+    struct Ops
+    {
+        void (*invoke)(void*);
+        void (*relocate)(void* from, void* to); // 移动构造到新位置并析构旧对象
+        void (*destroy)(void*);
+    };
+
+    template <typename Fn>
+    struct OpsFor_
+    {
+        static void Invoke(void* p) { (*static_cast<Fn*>(p))(); }
+        static void Relocate(void* from, void* to)
+        {
+            Fn* src = static_cast<Fn*>(from);
+            new (to) Fn(std::move(*src));
+            src->~Fn();
+        }
+        static void Destroy(void* p) { static_cast<Fn*>(p)->~Fn(); }
+        static const Ops ops;
+    };
+
+    void Reset_()
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(alignof(std::max_align_t)) char storage_[STORAGE_SIZE];
+    const Ops* ops_ = nullptr;
+    uint64_t stampUs_;
+};
+
+template <typename Fn>
+const InlineTask::Ops InlineTask::OpsFor_<Fn>::ops = {
+    &InlineTask::OpsFor_<Fn>::Invoke,
+    &InlineTask::OpsFor_<Fn>::Relocate,
+    &InlineTask::OpsFor_<Fn>::Destroy,
+};
+
+#endif // INLINE_TASK_H
@@ -5,20 +5,28 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
 #include <memory>
 #include <fstream>
 #include <cstdarg>
 
 /**
  * 异步并发日志系统
- * 
+ *
  * 设计亮点：
- * 1. 双缓冲队列 + 后台线程异步写盘，避免 IO 阻塞业务线程
+ * 1. 🌟 线程本地暂存 + 无锁 SPSC 环形队列交接：每个业务线程第一次打日志时
+ *    注册一条自己独占的环形队列，之后格式化和入队全程不碰任何锁；
+ *    后台写盘线程轮询所有环形队列统一落盘
  * 2. 支持按日期自动分割日志文件
  * 3. 四级日志：DEBUG / INFO / WARN / ERROR
- * 4. 线程安全：前端 mutex 保护入队，后端单线程顺序写盘
+ * 4. 显式溢出策略：环满时丢弃该条日志并累加计数器（不阻塞业务线程）
  * 5. 单例模式，全局可用
+ * 6. 🌟 可选二进制模式：业务线程只记录"格式串 ID + 原始参数字节"，
+ *    所有 vsnprintf 格式化推迟到离线读取时（tools/blogcat 渲染回文本）；
+ *    写盘线程把帧追加进 mmap 的预分配段文件，按大小滚动切段。
+ *    格式串在首次出现时以"定义帧"写进数据流，段文件自描述
  */
 
 class Log {
@@ -31,9 +39,12 @@ public:
         ERROR
     };
 
-    // 初始化：日志目录、日志文件后缀、最大队列容量、日志级别
+    // 初始化：日志目录、日志文件后缀、每线程环形队列容量、日志级别
+    // binaryMode: 打开二进制模式（格式化推迟到读取时，段文件用 tools/blogcat 渲染）
+    // segmentBytes: 二进制模式下单个段文件的预分配大小（写满即滚动切段）
     void Init(const char* path = "./log", const char* suffix = ".log",
-              int maxQueueCapacity = 8192, Level level = INFO);
+              int maxQueueCapacity = 8192, Level level = INFO,
+              bool binaryMode = false, size_t segmentBytes = 16 * 1024 * 1024);
 
     // 单例
     static Log* Instance();
@@ -51,13 +62,42 @@ public:
     // 日志是否已初始化
     bool IsOpen() const { return isOpen_; }
 
+    // 溢出丢弃的日志条数（供监控面使用）
+    uint64_t DroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
 private:
     Log();
     ~Log();
 
-    // 后台写线程函数
+    // 🌟 单生产者单消费者无锁环形队列：生产者是某个业务线程，消费者是写盘线程
+    struct SpscRing {
+        explicit SpscRing(size_t capacity); // 容量向上取整到 2 的幂
+        bool Push(std::string&& line);      // 满了返回 false（只被属主线程调用）
+        bool Pop(std::string& line);        // 空了返回 false（只被写盘线程调用）
+
+        std::vector<std::string> slots;
+        size_t mask;
+        // 读写游标分别独占缓存行，避免生产/消费两端伪共享
+        alignas(64) std::atomic<size_t> head{0}; // 消费端
+        alignas(64) std::atomic<size_t> tail{0}; // 生产端
+    };
+
+    // 取当前线程的环形队列（第一次调用时注册）
+    SpscRing* RingForThisThread_();
+
+    // 后台写线程函数：轮询所有线程的环形队列落盘
     void AsyncWriteThread_();
 
+    // ---- 二进制模式 ----
+    // 业务线程侧：编一帧（首次见到的格式串先编一条定义帧）
+    void WriteBinary_(Level level, const char* format, va_list args);
+    // 按格式串里的转换说明把 va_list 参数序列化成原始字节
+    static size_t EncodeArgs_(const char* format, va_list args, char* out, size_t cap);
+    // 写盘侧：帧追加进 mmap 段（满了滚动切段）；调用方持 fileMtx_
+    void AppendFrame_(const char* data, size_t len);
+    bool OpenSegment_();   // 预分配并 mmap 下一个段文件
+    void CloseSegment_();  // msync + 截断到实际长度 + munmap
+
     // 追加日志等级标签
     void AppendLogLevelTitle_(Level level, char* buf, int& idx);
 
@@ -78,27 +118,28 @@ private:
     bool isAsync_;                  // 是否异步模式
 
     std::ofstream fp_;              // 日志文件流
-    std::mutex mtx_;                // 前端入队锁
     std::mutex fileMtx_;            // 文件操作锁
 
-    // 阻塞队列（有界）
-    struct BlockQueue {
-        std::mutex mtx;
-        std::condition_variable condProducer;
-        std::condition_variable condConsumer;
-        std::queue<std::string> queue;
-        size_t capacity;
-        bool isClosed = false;
-
-        void Push(const std::string& item);
-        bool Pop(std::string& item);
-        void Close();
-        void Flush();
-        bool Empty();
-    };
+    size_t ringCapacity_;                          // 每线程环形队列容量
+    std::vector<std::shared_ptr<SpscRing>> rings_; // 所有已注册线程的环形队列
+    std::mutex ringRegMtx_;                        // 只保护注册（每线程一生一次）
+    std::atomic<uint64_t> dropped_{0};             // 溢出丢弃计数
 
-    std::unique_ptr<BlockQueue> blockQueue_;
+    std::condition_variable wakeCond_;  // 唤醒写盘线程
+    std::mutex wakeMtx_;
+    std::atomic<bool> stop_{false};
     std::unique_ptr<std::thread> writeThread_;
+
+    // ---- 二进制模式状态 ----
+    bool binary_ = false;           // 是否二进制模式
+    size_t segBytes_ = 0;           // 段文件预分配大小
+    int segFd_ = -1;                // 当前段文件 fd
+    char* segBase_ = nullptr;       // 当前段的 mmap 基址
+    size_t segOff_ = 0;             // 段内写偏移（段头之后）
+    int segSeq_ = 0;                // 段序号（文件名后缀）
+    std::unordered_map<const char*, uint32_t> fmtIds_; // 格式串字面量指针 -> ID
+    std::mutex fmtMtx_;             // 保护格式串注册表
+    uint32_t nextFmtId_ = 1;        // 下一个可分配的格式串 ID
 };
 
 // ===================== 便捷宏（核心面试亮点：零开销条件编译 + 格式化）=====================
@@ -0,0 +1,96 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <stdint.h>
+
+// 🌟 面试亮点：零争抢的运行时可观测层（Prometheus 文本格式）
+// 计数器和直方图按线程分片：每个线程写自己哈希到的分片（64 字节对齐，
+// 独占缓存行），热路径上一次 relaxed fetch_add，不会出现所有核在同一个
+// 原子变量上弹跳缓存行的情况；只有 /metrics 抓取时才跨分片聚合。
+// 延迟直方图按 2 的幂分桶（HDR 风格对数桶），覆盖 1us ~ 33s
+class Metrics
+{
+public:
+    // 热路径计数器
+    enum Counter
+    {
+        C_CONN_ACCEPTED = 0, // 接入的连接数
+        C_CONN_CLOSED,       // 关闭的连接数
+        C_READ_EVENTS,       // 读事件派发数
+        C_WRITE_EVENTS,      // 写事件派发数
+        C_HTTP_REQUESTS,     // 完整处理的 HTTP 请求数
+        C_TASKS_SUBMITTED,   // 提交进线程池的任务数
+        C_AI_CACHE_HITS,     // 推理结果缓存命中数
+        C_AI_CACHE_MISSES,   // 推理结果缓存未命中数
+        COUNTER_CNT
+    };
+
+    // 延迟直方图（单位都是微秒）
+    enum Histogram
+    {
+        H_REQUEST_US = 0,  // 读完成 -> 写完成的整请求延迟
+        H_TASK_WAIT_US,    // 任务在线程池队列里的等待时间（抽样）
+        H_AI_PREDICT_US,   // AIEngine::Predict 耗时
+        // 🌟 抽样分段追踪（1/64 请求，TSC 打点）：p99 飙了先看哪段变厚
+        H_STAGE_QUEUE_US,  // 事件出队 -> worker 任务开始（排队）
+        H_STAGE_PARSE_US,  // 任务开始 -> 解析完成（读 + 状态机）
+        H_STAGE_BUILD_US,  // 解析完成 -> 响应组装完成（路由/stat/DB）
+        H_STAGE_WRITE_US,  // 响应组装完成 -> 最后一个字节写出
+        HISTOGRAM_CNT
+    };
+
+    static constexpr int SHARD_CNT = 16;  // 分片数（2 的幂）
+    static constexpr int BUCKET_CNT = 26; // 桶数：le=1,2,4,...,2^24 us，最后 +Inf
+
+    static Metrics *Instance(); // 单例模式
+
+    // 计数器自增（relaxed，本线程分片）
+    void Inc(Counter c, uint64_t delta = 1);
+
+    // 观测一次延迟样本（微秒）
+    void Observe(Histogram h, uint64_t us);
+
+    // 注册抓取时才求值的仪表（队列深度、空闲连接数这类瞬时值）
+    void RegisterGauge(const char *name, std::function<uint64_t()> fn);
+
+    // 聚合所有分片，渲染成 Prometheus 文本
+    std::string Render();
+
+    // 单调时钟，微秒
+    static uint64_t NowUs();
+
+    // 🌟 TSC 时间戳：打点只花一条 rdtsc（~10ns，没有 vDSO 换算），
+    // 换算成微秒的除法推迟到样本被真正上报时才做。非 x86 退回 NowUs
+    static uint64_t NowTsc();
+    // TSC 差值换算成微秒（频率在进程启动时校准一次）
+    static uint64_t TscToUs(uint64_t tscDelta);
+
+private:
+    Metrics() = default;
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    // 每个分片独占缓存行起点，线程按 thread_local 序号哈希进来
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> counters[COUNTER_CNT];
+        std::atomic<uint64_t> buckets[HISTOGRAM_CNT][BUCKET_CNT];
+        std::atomic<uint64_t> sum[HISTOGRAM_CNT];   // 样本总和（算平均值用）
+        std::atomic<uint64_t> count[HISTOGRAM_CNT]; // 样本总数
+    };
+
+    Shard &LocalShard_(); // 本线程的分片
+
+    // 单例是静态存储期对象，Shard 数组享受零初始化，不需要显式清零
+    Shard shards_[SHARD_CNT];
+    std::atomic<int> nextShard_{0};
+
+    std::mutex gaugeMtx_; // 只保护注册表（注册发生在启动期，抓取频率很低）
+    std::vector<std::pair<std::string, std::function<uint64_t()>>> gauges_;
+};
+#endif // METRICS_H
@@ -0,0 +1,58 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class HttpConn;
+
+/*
+ * 🌟 面试亮点：O(1) 路由分发表
+ *
+ * 此前路由是 Process() 里一串 `if (method_ == "POST" && path_ == "/api/predict")`
+ * 内联字符串比较，登录逻辑还藏在解析器里——每加一个接口就多一组
+ * std::string 比较，业务代码越积越散。Router 把 (method, path) -> 处理函数
+ * 收敛成启动期注册的开放寻址哈希表：
+ *   - 查找是一次 FNV-1a 哈希 + 线性探测，零分配、零 string 构造
+ *   - 处理函数是 HttpConn 的成员函数指针，天然能访问连接的解析状态
+ *   - 查不到路由走默认路径（静态文件），行为和旧逻辑一致
+ * 注册只发生在启动期（单线程），之后全程只读，不需要锁。
+ */
+class Router
+{
+public:
+    typedef void (HttpConn::*Handler)(); // 处理函数：HttpConn 的成员函数
+
+    static Router *Instance();
+
+    // 启动期注册一条路由（重复注册同一 (method, path) 覆盖旧的）
+    // dbBound: 该路由要做数据库往返，派发到专职 DB 线程池而不占 worker
+    void Register(const char *method, const char *path, Handler handler,
+                  bool dbBound = false);
+
+    // 按 (method, path) 查处理函数，查不到返回 nullptr（走静态文件默认路由）
+    // dbBound 非空时带回该路由是否 DB 绑定
+    Handler Route(const std::string &method, const std::string &path,
+                  bool *dbBound = nullptr) const;
+
+private:
+    Router() = default;
+
+    // FNV-1a：method 和 path 连着喂，中间隔一个 0 字节防拼接歧义
+    static uint64_t Hash_(const char *method, size_t methodLen,
+                          const char *path, size_t pathLen);
+
+    struct Entry
+    {
+        std::string method;
+        std::string path;
+        Handler handler = nullptr;
+        bool dbBound = false; // 处理函数要做数据库往返
+    };
+
+    static const size_t TABLE_SIZE = 64; // 2 的幂；路由是个位数，装载率极低
+    Entry table_[TABLE_SIZE];
+};
+
+#endif // ROUTER_H
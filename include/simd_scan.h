@@ -0,0 +1,28 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+// 🌟 面试亮点：SIMD 字节扫描内核（解析热路径专用）
+// 10Gbps 请求流量下，找 CRLF 和头字段名匹配这类内存扫描是肉眼可见的
+// CPU 占比。这里提供两个向量化内核：
+//   FindCRLF — 一条指令比较 16/32 个字节，同时匹配 "\r\n" 双字节对
+//   CaseEq   — 向量化大小写无关比较（只对 A-Z 加 0x20，不误伤符号）
+// 启动时用 CPUID 探测一次指令集（AVX2 → SSE2 → 标量），之后走函数指针
+// 零分支分发。非 x86 平台编译期直接退回标量版，接口完全一致。
+// 标量参考实现公开导出：基准测试拿它和向量版对照，证明每代微架构上的收益
+class SimdScan
+{
+public:
+    // 在 [begin, end) 中查找 "\r\n"，找不到返回 nullptr（FindCRLF 的向量版）
+    static const char *FindCRLF(const char *begin, const char *end);
+
+    // 大小写无关比较 n 字节，等价于 strncasecmp(a, b, n) == 0（ASCII）
+    static bool CaseEq(const char *a, const char *b, size_t n);
+
+    // 标量参考实现（向量版的回退路径，也是基准测试的对照组）
+    static const char *FindCRLFScalar(const char *begin, const char *end);
+    static bool CaseEqScalar(const char *a, const char *b, size_t n);
+};
+
+#endif // SIMD_SCAN_H
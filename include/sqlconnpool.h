@@ -5,35 +5,51 @@
 #include <string>
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <memory>
 #include <semaphore.h> // 信号量，用来控制连接数量
 #include <thread>
-#include <memory>
 #include <iostream>
 #include <cassert>
 
 /*
  * 数据库连接池
  * 职责：负责创建、回收数据库连接
+ *
+ * 🌟 面试亮点：按 worker 线程分片的连接槽 + 共享溢出池
+ * 每个 worker 线程第一次取连接时分到一个专属槽位（取/还各一次 atomic
+ * exchange，常态下完全无争抢）；槽位空着（连接被借走或线程数多于连接数）
+ * 才退回到老的信号量+锁队列（溢出池）排队。登录这种 30% 请求都要打的
+ * 路径，热路径上不再有 sem_wait 和大锁。
+ *
+ * 🌟 面试亮点：每连接的预编译语句缓存（mysql_stmt_*）
+ * 以 SQL 文本为键缓存 MYSQL_STMT，同一个查询形状在同一条连接上
+ * 只 parse/plan 一次，之后全部走 execute
  */
 class SqlConnPool
 {
 public:
     static SqlConnPool *Instance(); // 单例模式，获取唯一实例
 
-    //// 初始化：主机、端口、用户名、密码、库名、池大小
+    //// 初始化：主机、端口、用户名、密码、库名、池大小、分片数（传 worker 线程数）
     void Init(const char *host, int port,
               const char *user, const char *pwd,
-              const char *dbName, int connSize = 10);
+              const char *dbName, int connSize = 10, int shardCnt = 0);
 
-    // 从池中取出一个连接
+    // 从池中取出一个连接（先试本线程的专属槽，再退到溢出池）
     MYSQL *GetConn();
 
-    // 释放连接，放回连接池
+    // 释放连接，放回连接池（优先归还进本线程槽位）
     void FreeConn(MYSQL *conn);
 
     // 获取当前空闲的连接数
     int GetFreeConnCount();
 
+    // 取该连接上缓存的预编译语句：首次调用 prepare，之后直接命中
+    // （调用方持有连接期间独占该连接，语句缓存不需要加锁）
+    MYSQL_STMT *PreparedStmt(MYSQL *sql, const char *query);
+
     // 销毁所有连接
     void DestroyPool();
 
@@ -41,13 +57,28 @@ private:
     SqlConnPool();  // 构造函数私有化，防止外部创建
     ~SqlConnPool(); // 析构函数私有化，防止外部删除
 
+    int ShardIdx_(); // 本线程的分片序号（首次调用时轮转分配）
+
     int MAX_CONN_;  // 连接池最大连接数
     int useCount_;  // 已使用的连接数
     int freeCount_; // 空闲的连接数
 
-    std::queue<MYSQL *> connQue_; // 连接池队列
-    std::mutex mtx_;              // 互斥锁，保护连接池队列
-    sem_t semId_;                 // 信号量，控制连接数量
+    // 每线程专属连接槽：独占缓存行，取/还是一次无锁 exchange
+    struct alignas(64) Shard
+    {
+        std::atomic<MYSQL *> slot{nullptr};
+    };
+    int shardCnt_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<int> nextShard_{0};
+
+    std::queue<MYSQL *> connQue_; // 溢出池队列（分片槽不够用时的后备）
+    std::mutex mtx_;              // 互斥锁，保护溢出池队列
+    sem_t semId_;                 // 信号量，控制溢出池连接数量
+
+    // 每连接的语句缓存：外层映射在 Init 里建好后只读（find 不再加锁），
+    // 内层缓存只被当前持有该连接的线程访问
+    std::unordered_map<MYSQL *, std::unordered_map<std::string, MYSQL_STMT *>> stmtCache_;
 };
 
 /* RAII 机制封装类
@@ -74,4 +105,4 @@ private:
     MYSQL *sql_;               // 当前连接
     SqlConnPool *pool_;        // 连接池
 };
-#endif // SQLCONNPOOL_H
\ No newline at end of file
+#endif // SQLCONNPOOL_H
@@ -3,43 +3,177 @@
 
 #include <mutex>
 #include <condition_variable>
-#include <queue>
+#include <atomic>
 #include <thread>
 #include <functional>
 #include <vector>
 #include <memory> // shared_ptr 需要
 #include <cassert> // assert 需要
+#include <pthread.h> // 【新增】pthread_setaffinity_np 钉核
+#include <sched.h>
+#include "metrics.h" // 【新增】队列深度/任务等待时间上报
+#include "inlinetask.h" // 【新增】定容无分配任务类型
+
+/*
+ * 🌟 面试亮点：有界无锁 MPMC 环形队列 (Dmitry Vyukov 算法)
+ *
+ * 每个槽位带一个序号 (seq)：
+ *   - seq == 槽下标        表示槽空，可以写
+ *   - seq == 槽下标 + 1    表示槽满，可以读
+ * 生产者/消费者只用 CAS 推进自己的游标，入队出队全程不加锁，
+ * 彻底消除 reactor 和 worker 之间在一把大锁上的串行化。
+ */
+template <typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(size_t capacity)
+        : buffer_(capacity), mask_(capacity - 1), enqueuePos_(0), dequeuePos_(0)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0); // 容量必须是 2 的幂
+        for (size_t i = 0; i < capacity; i++)
+        {
+            buffer_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 入队：队列满返回 false（有界 → 自带背压）
+    bool Push(T &&item)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &buffer_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                // 槽空，尝试占位
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 队列满
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed); // 被别人抢了，重读
+            }
+        }
+        cell->data = std::move(item);
+        cell->seq.store(pos + 1, std::memory_order_release); // 发布：槽满
+        return true;
+    }
+
+    // 出队：队列空返回 false
+    bool Pop(T &item)
+    {
+        Cell *cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &buffer_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                // 槽满，尝试占位
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 队列空
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release); // 归还：槽空（下一圈）
+        return true;
+    }
+
+    // 近似队列深度（两个游标的 relaxed 读，够监控用）
+    size_t Size() const
+    {
+        size_t enq = enqueuePos_.load(std::memory_order_relaxed);
+        size_t deq = dequeuePos_.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T data;
+    };
+    std::vector<Cell> buffer_;
+    size_t mask_;
+    // 读写游标分别独占一条缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> enqueuePos_;
+    alignas(64) std::atomic<size_t> dequeuePos_;
+};
 
 class ThreadPool {
 public:
     // 构造函数：默认创建 8 个线程
-    // 删除了 ThreadPool() = default 以避免歧义
-    explicit ThreadPool(size_t threadCount = 8) : pool_(std::make_shared<Pool>()) {
+    // workerCpus 非空时 worker i 钉到 workerCpus[i % size]（NUMA 布局见 CpuPlacement）
+    explicit ThreadPool(size_t threadCount = 8,
+                        const std::vector<int>& workerCpus = std::vector<int>())
+        : pool_(std::make_shared<Pool>()) {
         assert(threadCount > 0);
 
         // 创建 threadCount 个线程
         for(size_t i = 0; i < threadCount; i++) {
-            std::thread([pool = pool_] {
-                std::unique_lock<std::mutex> locker(pool->mtx);
+            int cpu = workerCpus.empty() ? -1 : workerCpus[i % workerCpus.size()];
+            std::thread([pool = pool_, cpu] {
+                if(cpu >= 0) {
+                    // 钉核后 worker 的栈页和它首次触碰的缓冲块都落在本节点内存
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(cpu, &set);
+                    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+                }
+                InlineTask task;
+                // 出队后执行：带抽样戳的任务顺手上报队列等待时间
+                auto runTask = [&task]() {
+                    if(task.Stamp() != 0) {
+                        Metrics::Instance()->Observe(Metrics::H_TASK_WAIT_US,
+                                                     Metrics::NowUs() - task.Stamp());
+                    }
+                    task();
+                };
                 while(true) {
-                    if(!pool->tasks.empty()) {
-                        // 1. 取出任务
-                        auto task = std::move(pool->tasks.front());
-                        pool->tasks.pop();
-                        
-                        // 2. 核心：任务执行时解锁，允许其他线程并发取任务
+                    // 1. 快路径：无锁出队
+                    if(pool->tasks.Pop(task)) {
+                        runTask();
+                        continue;
+                    }
+                    // 2. 队列空：先自旋几轮再睡，避免事件风暴下频繁陷内核
+                    bool got = false;
+                    for(int spin = 0; spin < 64; spin++) {
+                        std::this_thread::yield();
+                        if(pool->tasks.Pop(task)) { got = true; break; }
+                    }
+                    if(got) { runTask(); continue; }
+                    // 3. 真没活了：挂到条件变量上（锁只在"睡/醒"边沿出现，不在热路径）
+                    std::unique_lock<std::mutex> locker(pool->mtx);
+                    pool->sleepers++;
+                    // wait 前再试一次，堵住"检查空 -> 生产者入队并通知 -> 才开始睡"的窗口
+                    if(pool->tasks.Pop(task)) {
+                        pool->sleepers--;
                         locker.unlock();
-                        
-                        task(); // 执行任务
-                        
-                        locker.lock(); // 重新加锁准备取下一个
-                    } 
-                    else if(pool->isClosed) {
-                        break; // 队列空了且已关闭，退出线程
-                    } 
-                    else {
-                        pool->cond.wait(locker); // 等待唤醒
+                        runTask();
+                        continue;
                     }
+                    if(pool->isClosed) { break; }
+                    pool->cond.wait(locker);
+                    pool->sleepers--;
+                    if(pool->isClosed) { break; }
                 }
             }).detach(); // 线程分离
         }
@@ -47,7 +181,7 @@ public:
 
     // 移动构造函数
     ThreadPool(ThreadPool&&) = default;
-    
+
     // 析构函数
     ~ThreadPool() {
         if(static_cast<bool>(pool_)) {
@@ -59,24 +193,61 @@ public:
         }
     }
 
-    // 添加任务
+    // 添加单个任务（无锁入队 + 仅在有线程睡着时才通知）
+    // 🌟 任务是 InlineTask：闭包就地构造在任务对象里，入队出队零堆分配
     template<class F>
     void AddTask(F&& task) {
-        {
-            std::lock_guard<std::mutex> locker(pool_->mtx);
-            pool_->tasks.emplace(std::forward<F>(task));
+        InlineTask fn(std::forward<F>(task));
+        while(!pool_->tasks.Push(std::move(fn))) {
+            std::this_thread::yield(); // 队列满：让出 CPU 等 worker 消化（背压）
         }
-        pool_->cond.notify_one();
+        Metrics::Instance()->Inc(Metrics::C_TASKS_SUBMITTED);
+        NotifyIfSleeping_(1);
     }
 
+    // 🌟 批量提交：reactor 每次 epoll_wait 醒来把所有就绪 fd 的任务一次性交进来，
+    //    N 个任务只做一轮通知，而不是 N 次 notify_one
+    void AddTasks(std::vector<InlineTask>& batch) {
+        if(batch.empty()) { return; }
+        for(auto& fn : batch) {
+            // 每 64 个任务抽样一个测队列等待时间：戳直接写在任务对象上，
+            // 不用再包一层闭包（那一层捕获会把任何任务都撑爆内联容量）
+            thread_local uint32_t sampleTick = 0;
+            if((++sampleTick & 63) == 0) {
+                fn.SetStamp(Metrics::NowUs());
+            }
+            while(!pool_->tasks.Push(std::move(fn))) {
+                std::this_thread::yield();
+            }
+        }
+        Metrics::Instance()->Inc(Metrics::C_TASKS_SUBMITTED, batch.size());
+        NotifyIfSleeping_(batch.size());
+        batch.clear();
+    }
+
+    // 当前任务队列深度（监控仪表用）
+    size_t QueueSize() const { return pool_->tasks.Size(); }
+
 private:
+    void NotifyIfSleeping_(size_t taskCnt) {
+        // 没人睡着就一次系统调用都不花（seq_cst 读，和 worker 的 sleepers++ 保持全序）
+        if(pool_->sleepers.load() == 0) { return; }
+        std::lock_guard<std::mutex> locker(pool_->mtx);
+        if(taskCnt > 1) {
+            pool_->cond.notify_all();
+        } else {
+            pool_->cond.notify_one();
+        }
+    }
+
     struct Pool {
-        std::mutex mtx;
+        MpmcQueue<InlineTask> tasks{4096}; // 有界无锁任务队列（任务零堆分配）
+        std::mutex mtx;                 // 只保护"睡/醒"边沿
         std::condition_variable cond;
-        bool isClosed = false; // 默认初始化为 false
-        std::queue<std::function<void()>> tasks;
+        std::atomic<int> sleepers{0};   // 当前睡着的 worker 数
+        bool isClosed = false;          // 默认初始化为 false
     };
     std::shared_ptr<Pool> pool_;
 };
 
-#endif // THREADPOOL_H
\ No newline at end of file
+#endif // THREADPOOL_H
@@ -0,0 +1,77 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include "inlinetask.h"
+
+// 【新增】回调改用定容无分配的 InlineTask：add/adjust 高频路径不再碰堆
+typedef InlineTask TimeoutCallBack;
+typedef std::chrono::steady_clock Clock;
+typedef std::chrono::milliseconds MS;
+typedef Clock::time_point TimeStamp;
+
+/*
+ * 🌟 面试亮点：哈希时间轮 (hashed timer wheel)
+ *
+ * 替换掉原来的小根堆定时器：堆的 adjust 是 O(log n) 的锁内 siftdown，
+ * 每个读写事件都要做一次；连接空闲超时根本不需要毫秒精度，需要的是"免费"。
+ * 时间轮把超时挂到按秒分格的环形槽上：
+ *   - add / adjust / cancel 都是 O(1) 的链表摘挂
+ *   - tick 只扫过期的槽，每秒一格
+ * 超过一圈的超时用 rounds 计数解决（60s 超时在 128 格的轮里用不到）。
+ * 对外接口和 HeapTimer 完全一致，WebServer 不用改。
+ */
+class TimerWheel {
+public:
+    TimerWheel();
+    ~TimerWheel() { clear(); }
+
+    // 调整指定 id 的定时器 (客户端发来心跳，延长超时时间) —— O(1)
+    void adjust(int id, int timeout);
+
+    // 添加一个新的定时器 —— O(1)（回调按值移入，InlineTask 不可拷贝）
+    void add(int id, int timeout, TimeoutCallBack&& cb);
+
+    // 提前触发并删除指定的定时器
+    void doWork(int id);
+
+    // 只删除定时器，不执行回调（用于主动关闭连接时避免递归）
+    void cancel(int id);
+
+    // 清除所有定时器
+    void clear();
+
+    // 核心逻辑：推进轮子，执行所有已过期槽位的回调
+    void tick();
+
+    // 获取下一个定时器的超时时间 (给 epoll_wait 用)
+    int GetNextTick();
+
+private:
+    // 定时器节点：挂在槽位的双向链表上
+    struct Node {
+        int id;             // 用来标记定时器，通常是客户端的 fd
+        int rounds;         // 还要转几圈才到期
+        size_t slot;        // 所在槽位（cancel/adjust 时摘链用）
+        TimeoutCallBack cb; // 超时后的回调函数 (比如关闭该 fd)
+        Node* prev = nullptr;
+        Node* next = nullptr;
+    };
+
+    static const size_t SLOT_MS = 1000;   // 槽位粒度：1 秒
+    static const size_t WHEEL_SIZE = 128; // 槽位数：覆盖 128 秒
+
+    void Link_(Node* node, int timeoutMS);   // 按超时挂进对应槽位（调用方持锁）
+    void Unlink_(Node* node);                // 从槽位链表上摘下（调用方持锁）
+
+    std::vector<Node*> slots_;            // 每个槽位的链表头
+    std::unordered_map<int, Node*> ref_;  // 映射：fd -> 节点 (O(1) 查找)
+    size_t cursor_;                       // 当前指向的槽位
+    TimeStamp lastTick_;                  // 上次推进轮子的时间
+    std::mutex mtx_;                      // 保护轮子和映射的线程安全锁
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,63 @@
+#ifndef URING_POLLER_H
+#define URING_POLLER_H
+#ifdef ENABLE_IO_URING
+
+#include <liburing.h>
+#include <stdint.h>
+#include <sys/epoll.h> // 事件位掩码沿用 EPOLLIN/EPOLLOUT 等定义
+#include <unordered_map>
+#include <vector>
+
+// 🌟 面试亮点：io_uring 后端（编译期可选，-DENABLE_IO_URING）
+// 与 Epoller 接口完全一致，WebServer 通过别名切换后端，上层零改动。
+// 用 POLL_ADD SQE 替代 epoll_ctl：armed 一次性 poll 天然等价于 EPOLLONESHOT，
+// 省掉了每次事件后的 epoll_ctl 重挂系统调用（提交和等待在 Wait 里合并成
+// 一次 io_uring_enter），这是 6.x 内核上砍半 syscall 开销的第一步
+class UringPoller
+{
+private:
+    // 就绪事件平铺成 {fd, events}，和 epoll_event 数组的消费方式对齐
+    struct Ready
+    {
+        int fd;
+        uint32_t events;
+    };
+
+    struct io_uring ring_;     // io_uring 实例（SQ/CQ 共享内存环）
+    std::vector<Ready> ready_; // 本轮 Wait 收割到的就绪事件
+    size_t readyCnt_;          // 本轮就绪事件数
+
+    // 【修正】持久挂载表：epoll 语义下不带 EPOLLONESHOT 的注册（监听
+    // socket、eventfd）触发后仍然在位，但一次性 poll 消费完就消失。
+    // 这里记下这类 fd 的事件掩码，Wait 收割到它的完成后自动补挂一个
+    // 新的 POLL_ADD——否则 listenFd 只能 accept 一批、eventfd 只能醒一次
+    std::unordered_map<int, uint32_t> persistent_;
+
+    struct io_uring_sqe *GetSqe_(); // 取 SQE，环满时先提交腾位置
+
+public:
+    explicit UringPoller(int maxEvent = 1024);
+
+    // 挂一个一次性 poll（语义对应 epoll 的 EPOLLONESHOT 挂载）
+    bool AddFd(int fd, uint32_t events);
+
+    // 重新武装：一次性 poll 触发后即消失，Mod 就是再挂一次
+    bool ModFd(int fd, uint32_t events);
+
+    // 撤销尚未触发的 poll
+    bool DelFd(int fd);
+
+    // 提交攒下的 SQE 并等待完成事件，返回就绪事件数
+    int Wait(int timeoutMs = -1);
+
+    // 获取第i个就绪事件的 fd
+    int GetEventFd(size_t i) const;
+
+    // 获取第i个就绪事件的事件类型
+    uint32_t GetEvents(size_t i) const;
+
+    ~UringPoller();
+};
+
+#endif // ENABLE_IO_URING
+#endif // URING_POLLER_H
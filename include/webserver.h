@@ -2,6 +2,8 @@
 #define WEBSERVER_H
 
 #include <unordered_map>
+#include <vector>
+#include <thread>
 #include <fcntl.h>  // fcntl()
 #include <unistd.h> // close()
 #include <assert.h>
@@ -11,59 +13,181 @@
 #include <arpa/inet.h>
 
 #include "epoller.h"
+#include "uring_poller.h"
 #include "threadpool.h"
 #include "sqlconnpool.h"
 #include "httpconn.h"
-#include "heaptimer.h"
+#include "timerwheel.h"
 
 // 全局优雅关闭标志（由信号处理函数设置）
 extern volatile int g_shutdown;
 
+// 🌟 IO 后端编译期切换：-DENABLE_IO_URING 换成 io_uring，接口完全一致，
+// WebServer 只认这个别名，上层代码零改动
+#ifdef ENABLE_IO_URING
+using Poller = UringPoller;
+#else
+using Poller = Epoller;
+#endif
+
+// 🌟 连接建立策略：新连接上要打的 socket 选项，一处配置
+// （LB 故障切换后的连接风暴窗口里，accept 路径的每个 syscall 都是恢复时间）
+struct SockPolicy
+{
+    bool tcpNoDelay = true;  // 关 Nagle：小的 keep-alive 响应不再等 40ms ACK
+    int rcvBufBytes = 0;     // SO_RCVBUF（0 = 用内核默认并自动调优）
+    int sndBufBytes = 0;     // SO_SNDBUF（0 = 用内核默认并自动调优）
+    int deferAcceptSec = 1;  // TCP_DEFER_ACCEPT：握手完成且有数据到达才唤醒 accept
+};
+
+// 🌟 CPU 亲和性布局：把 reactor 和 worker 钉在指定核上，一处配置
+// 双路机器上按 NUMA 节点配对（同分片的 reactor 和 worker 给同节点的核），
+// 消除 reactor 填 Buffer、worker 解析之间的跨节点缓存行弹跳。
+// Buffer/缓冲池的块都是线程首次触碰时才分配的（first-touch），
+// 钉核之后页自然落在本节点内存上，不需要额外的 NUMA 分配接口。
+// 两个列表留空 = 不钉核，沿用调度器的默认行为
+struct CpuPlacement
+{
+    std::vector<int> reactorCpus; // 分片 i 钉到 reactorCpus[i % size]
+    std::vector<int> workerCpus;  // worker i 钉到 workerCpus[i % size]
+};
+
+// 🌟 warm-start 配置：部署/故障切换后的头 30 秒不该是 p99 的重灾区。
+// 构造函数在监听 socket 上线前把冷的东西全摸热：slab 连接表预建、
+// 缓冲池预分配并触页、静态文件预灌文件缓存、AI 引擎跑几次空推理。
+// /healthz 在预热跑完前返回 503，LB 只把流量切给已预热的进程
+struct WarmStart
+{
+    int connSlots = 1024;             // 每分片预建的 HttpConn 槽位数（0 = 不预建）
+    size_t poolChunksPerClass = 256;  // BufferPool 每个大小级预热的块数
+    size_t preloadMaxBytes = 32 * 1024 * 1024; // 文件缓存预灌的总字节预算（0 = 不预灌）
+    int aiWarmupRuns = 4;             // AI 引擎空推理次数（模型没加载则跳过）
+};
+
 class WebServer
 {
 public:
     // 构造函数：传入端口号、网站根目录、数据库账号密码等
+    // reactorNum: Reactor 分片数（每个分片独占一个事件循环线程，通过 SO_REUSEPORT 分流连接）
+    // sockPolicy: 连接建立时的 socket 选项策略（见 SockPolicy）
+    // placement: reactor/worker 的 CPU 钉核布局（见 CpuPlacement，默认不钉）
+    // warm: 启动期预热配置（见 WarmStart，默认开启一套适中的预热量）
     WebServer(int port, const char *srcDir,
               const char *sqlUser, const char *sqlPwd, const char *dbName,
-              int connPoolNum, int threadNum);
+              int connPoolNum, int threadNum, int reactorNum = 1,
+              SockPolicy sockPolicy = SockPolicy(),
+              CpuPlacement placement = CpuPlacement(),
+              WarmStart warm = WarmStart());
     ~WebServer();
 
     void Start();
 
 private:
+    // 🌟 面试亮点：eventfd 跨线程唤醒 + 延迟 epoll 操作队列
+    // worker 线程不再自己调 epoll_ctl（那会和 reactor 的 epoll_wait 抢内核锁），
+    // 而是把 mod/close 操作投进本分片的无锁队列并敲一下 eventfd；
+    // reactor 在每轮循环顶部把整批操作串行执行，缓存友好且可即时被唤醒
+    struct EpollOp
+    {
+        enum Type { OP_MOD, OP_CLOSE };
+        Type type;
+        int fd;
+        uint32_t events;   // OP_MOD 用
+        HttpConn *client;  // 投递时的连接指针，用于识别 fd 被复用的迟到操作
+    };
+
+    // 🌟 面试亮点：多 Reactor 分片（Multi-Reactor）
+    // 每个分片独占自己的监听 socket (SO_REUSEPORT)、Epoller、连接表和定时器，
+    // 内核按四元组哈希把新连接分到不同分片，热路径上分片之间零共享状态
+    struct Reactor
+    {
+        int id = 0;                                // 分片编号
+        int listenFd = -1;                         // 本分片的监听 socket
+        std::unique_ptr<Poller> epoller;           // 本分片的 IO 多路复用器（epoll 或 io_uring）
+        std::unique_ptr<TimerWheel> timer;         // 本分片的定时器（时间轮）
+
+        // 🌟 slab 连接表：fd 是稠密小整数，直接用 fd 当下标索引，
+        // 事件派发就是一次带边界检查的数组寻址——没有哈希、没有 rehash 抖动；
+        // 槽位里的 HttpConn（连同它的两个 Buffer）断开后原地复用，预热后零分配
+        std::vector<std::unique_ptr<HttpConn>> users; // 槽位表: users[fd]
+        std::vector<uint32_t> gens;                   // 每槽世代号：识别"旧连接的定时器回调打到新连接"
+        std::vector<InlineTask> pending;              // 本轮 epoll_wait 攒下的任务，批量交给线程池
+
+        uint64_t lastSweepUs = 0;             // 上次空闲内存回收扫描的时刻
+        bool draining = false;                // 本分片已进入排水模式（不再 accept）
+        uint64_t drainDeadlineUs = 0;         // 排水期限：过点强关剩余连接
+        uint32_t traceTick = 0;               // 分段追踪抽样计数（每 64 个读事件抽 1 个）
+        int wakeFd = -1;                      // eventfd：worker 敲门用
+        MpmcQueue<EpollOp> ops{1024};         // worker 投递的延迟 epoll 操作
+        std::atomic<bool> wakePending{false}; // 去重：一轮只需要敲一次门
+    };
+
+    // 延迟 epoll 操作队列
+    void PostOp_(Reactor &reactor, EpollOp op); // worker 线程投递操作并唤醒 reactor
+    void DrainOps_(Reactor &reactor);           // reactor 串行执行攒下的操作
+
+    // slab 连接表辅助函数
+    void EnsureSlot_(Reactor &reactor, int fd);      // 保证 fd 对应槽位存在
+    HttpConn *GetConn_(Reactor &reactor, int fd);    // 取活跃连接，槽位空/已关闭返回 nullptr
+
+    // --- 优雅排水与热升级 ---
+    void StartDrain_(Reactor &reactor);  // 本分片进入排水：摘监听、启动 fd 交接
+    void StartHandoverOnce_();           // 全局一次：起线程把监听 fd 递给新进程
+    int CountLive_(Reactor &reactor);    // 本分片还有几条活连接
+    void ForceCloseAll_(Reactor &reactor); // 排水超时：强关剩余连接
+
+    // --- 启动期预热 ---
+    void WarmUp_(const WarmStart &warm);                    // 跑完整个 warm-start 阶段
+    void PreloadDir_(const std::string &dir, size_t &budget); // 递归预灌文件缓存（budget 递减）
+
     // --- 核心网络初始化 ---
-    bool InitSocket_(); // 初始化监听 socket
-    void InitEventMode_();// 初始化事件模式（LT/ET）
-    void AddClient_(int fd, sockaddr_in addr); // 添加新客户端连接
-    void DealListen_(); // 处理监听事件
-    void CloseConn_(HttpConn* client);
+    bool InitSocket_(Reactor &reactor); // 初始化某个分片的监听 socket
+    void InitEventMode_();              // 初始化事件模式（LT/ET）
+    void EventLoop_(Reactor &reactor);  // 单个分片的事件循环
+    void AddClient_(Reactor &reactor, int fd, sockaddr_in addr); // 添加新客户端连接
+    void DealListen_(Reactor &reactor); // 处理监听事件
+    void CloseConn_(Reactor &reactor, HttpConn *client);
 
     // --- 事件处理派发 ---
-    void DealRead_(HttpConn *client); // 处理读事件(丢进线程池)
-    void DealWrite_(HttpConn *client); // 处理写事件（丢进线程池）
+    void DealRead_(Reactor &reactor, HttpConn *client);  // 处理读事件(丢进线程池)
+    void DealWrite_(Reactor &reactor, HttpConn *client); // 处理写事件（丢进线程池）
 
     // --- 线程池实际执行的函数 ---
-    void OnRead_(HttpConn* client);
-    void OnWrite_(HttpConn* client);
-    void OnProcess_(HttpConn* client);
+    void OnRead_(Reactor &reactor, HttpConn *client);
+    void OnWrite_(Reactor &reactor, HttpConn *client);
+    void OnProcess_(Reactor &reactor, HttpConn *client);
+    void OnDbWork_(Reactor &reactor, HttpConn *client); // DB 线程池执行泊车的数据库请求
 
     // --- 服务器基础配置 ---
     int port_;
     bool isClose_;
-    int listenFd_;
-    char* srcDir_;
+    char *srcDir_;
 
     // --- Epoll 事件模式 (LT/ET) ---
     uint32_t listenEvent_; // 监听 Socket 的事件模式
     uint32_t connEvent_;   // 客户端 Socket 的事件模式
 
-    // --- 三大核心组件 ---
-    std::unique_ptr<Epoller> epoller_;         // IO多路复用
-    std::unique_ptr<ThreadPool> threadpool_;   // 线程池
-    std::unordered_map<int, HttpConn> users_;  // 保存所有客户端连接映射: fd -> HttpConn
+    // --- 核心组件 ---
+    int reactorNum_;                                 // Reactor 分片数
+    std::vector<std::unique_ptr<Reactor>> reactors_; // 所有分片
+    std::unique_ptr<ThreadPool> threadpool_;         // 线程池（所有分片共享）
+
+    // 🌟 专职 DB 线程池：SQL 绑定的请求泊车后在这里完成数据库往返，
+    // 数据库变慢只堵这几条线程，worker 池和静态文件路径不受头部阻塞牵连
+    std::unique_ptr<ThreadPool> dbPool_;
 
-    int timeoutMS_;  // 默认超时时间 (比如 60000 毫秒)
-    std::unique_ptr<HeapTimer> timer_;
+    int timeoutMS_; // 默认超时时间 (比如 60000 毫秒)
+    SockPolicy sockPolicy_; // 连接建立时的 socket 选项策略
+    CpuPlacement placement_; // reactor/worker 的 CPU 钉核布局
 
+    // 🌟 优雅排水与零停机热升级：
+    // SIGTERM (g_shutdown) 不再直接掐断事件循环，而是进入 drain 模式——
+    // 摘掉监听 socket、/healthz 翻 503、在途连接继续送完；超过排水
+    // 期限后强关剩余连接退出。同时把各分片的监听 fd 经 unix socket
+    // (SCM_RIGHTS) 递给新 exec 的二进制：新老进程共享 accept 队列，
+    // 新进程先开张、老进程后谢幕，LB 的延迟曲线上看不到这次部署
+    int drainTimeoutMS_ = 10000;             // 排水期限（超时强关）
+    std::atomic<bool> handoverStarted_{false}; // fd 交接只做一次（哪个分片先排水谁触发）
+    std::vector<int> inheritedFds_;          // 从老进程继承的监听 fd（冷启动为空）
 };
-#endif // WEBSERVER_H
\ No newline at end of file
+#endif // WEBSERVER_H
@@ -126,6 +126,8 @@ int main() {
         
         int sqlPoolNum = 4;
         int threadNum = 8; // 八核动力
+        // 【新增】Reactor 分片数（SO_REUSEPORT 多事件循环，默认 2 个分片）
+        int reactorNum = atoi(GetEnvOrDefault("SERVER_REACTORS", "2"));
 
         LOG_INFO("Starting WebServer on port %d...", port);
         LOG_INFO("Connecting to MySQL: user=%s, db=%s", sqlUser, dbName);
@@ -145,7 +147,8 @@ int main() {
             port, 
             srcDir, 
             sqlUser, sqlPwd, dbName, 
-            sqlPoolNum, threadNum
+            sqlPoolNum, threadNum,
+            reactorNum
         );
 
         server.Start(); // 死循环，永不退出
@@ -1,12 +1,23 @@
 #include "ai_engine.h"
 #include "log.h"
+#include "metrics.h" // 【新增】推理耗时直方图
+#include <chrono>
 
 AIEngine::AIEngine() : memoryInfo_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
     // 初始化 ONNX Runtime 环境，设置日志级别为 WARNING
     env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "AIEngine");
 }
 
-AIEngine::~AIEngine() {}
+AIEngine::~AIEngine() {
+    // 停掉所有攒批线程
+    stop_ = true;
+    jobCond_.notify_all();
+    for (auto& t : batchThreads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
 
 AIEngine* AIEngine::Instance() {
     static AIEngine engine;
@@ -14,22 +25,51 @@ AIEngine* AIEngine::Instance() {
 }
 
 bool AIEngine::LoadModel(const std::string& modelPath) {
+    return LoadModel(modelPath, ModelOptions());
+}
+
+bool AIEngine::LoadModel(const std::string& modelPath, const ModelOptions& opts) {
     try {
         Ort::SessionOptions sessionOptions;
-        // 设置为单线程执行图，或者根据你的 CPU 核心数调整
-        sessionOptions.SetIntraOpNumThreads(1); 
-        // 开启所有的图优化 (面试亮点：图优化机制)
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        // 线程数从配置来，不再硬编码（面试亮点：图优化机制）
+        sessionOptions.SetIntraOpNumThreads(opts.intraOpThreads);
+        sessionOptions.SetInterOpNumThreads(opts.interOpThreads);
+        switch (opts.graphOptLevel) {
+            case 0:  sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL); break;
+            case 1:  sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC); break;
+            case 2:  sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED); break;
+            default: sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL); break;
+        }
 
-        // 加载模型到内存
-        session_ = std::make_unique<Ort::Session>(*env_, modelPath.c_str(), sessionOptions);
+        // 🌟 建 session 池：N 个会话挂在同一个 env_ 上，ORT 内部共享模型权重，
+        // 内存只多花会话自身的执行状态，却换来 N 路并发 Run
+        int sessionNum = opts.sessionNum > 0 ? opts.sessionNum : 1;
+        for (int i = 0; i < sessionNum; i++) {
+            sessions_.push_back(
+                std::make_unique<Ort::Session>(*env_, modelPath.c_str(), sessionOptions));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sessMtx_);
+            freeSessions_.clear();
+            for (auto& s : sessions_) {
+                freeSessions_.push_back(s.get());
+            }
+        }
 
         // 为了简化，这里硬编码输入输出节点的名字。
         // 实际工业界会通过 session_->GetInputNameAllocated 动态获取
         inputNodeNames_ = {"input"};   // 必须与你 ONNX 模型的输入名一致
         outputNodeNames_ = {"output"}; // 必须与你 ONNX 模型的输出名一致
 
-        LOG_INFO("[AIEngine] Model loaded successfully from %s", modelPath.c_str());
+        loaded_ = true;
+
+        // 每个 session 一条攒批线程：各自从公共队列出批，并发推理
+        while ((int)batchThreads_.size() < sessionNum) {
+            batchThreads_.emplace_back(&AIEngine::BatchLoop_, this);
+        }
+
+        LOG_INFO("[AIEngine] Model loaded from %s (%d sessions, intraOp=%d interOp=%d)",
+                 modelPath.c_str(), sessionNum, opts.intraOpThreads, opts.interOpThreads);
         return true;
     } catch (const Ort::Exception& e) {
         LOG_ERROR("[AIEngine] Failed to load model: %s", e.what());
@@ -37,29 +77,191 @@ bool AIEngine::LoadModel(const std::string& modelPath) {
     }
 }
 
-// 核心前向传播逻辑
+// 借出一个空闲会话：池空就等归还（池大小 = 攒批线程数，等待只在关停路径出现）
+Ort::Session* AIEngine::GetSession() {
+    std::unique_lock<std::mutex> lock(sessMtx_);
+    sessCond_.wait(lock, [this] { return !freeSessions_.empty(); });
+    Ort::Session* sess = freeSessions_.back();
+    freeSessions_.pop_back();
+    return sess;
+}
+
+// 归还会话
+void AIEngine::FreeSession(Ort::Session* sess) {
+    {
+        std::lock_guard<std::mutex> lock(sessMtx_);
+        freeSessions_.push_back(sess);
+    }
+    sessCond_.notify_one();
+}
+
+// 输入量化成缓存键：1e-3 精度取整后的 int32 序列按字节拼接，
+// 同一业务输入带点浮点噪声也能命中同一条缓存
+std::string AIEngine::CacheKey_(const std::vector<float>& input) {
+    std::string key;
+    key.reserve(input.size() * sizeof(int32_t));
+    for (float v : input) {
+        int32_t q = (int32_t)(v * 1000.0f + (v >= 0 ? 0.5f : -0.5f));
+        key.append(reinterpret_cast<const char*>(&q), sizeof(q));
+    }
+    return key;
+}
+
+// 缓存查询：命中则提到 LRU 头部；过期条目当场摘掉
+bool AIEngine::PredictCache::Get(const std::string& key, std::vector<float>& out) {
+    Shard& shard = shards[std::hash<std::string>()(key) & (SHARD_CNT - 1)];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    if (Metrics::NowUs() >= it->second->second.expireUs) {
+        // TTL 到了：模型可能已重载，旧结果作废
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    it->second = shard.lru.begin();
+    out = it->second->second.output;
+    return true;
+}
+
+// 缓存写入：容量满时踢掉 LRU 尾部
+void AIEngine::PredictCache::Put(const std::string& key, const std::vector<float>& out,
+                                 uint64_t ttlUs) {
+    Shard& shard = shards[std::hash<std::string>()(key) & (SHARD_CNT - 1)];
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // 已有条目（两个线程撞车算了同一个输入）：刷新结果和 TTL
+        it->second->second.output = out;
+        it->second->second.expireUs = Metrics::NowUs() + ttlUs;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        it->second = shard.lru.begin();
+        return;
+    }
+    shard.lru.emplace_front(key, Entry{out, Metrics::NowUs() + ttlUs});
+    shard.index[key] = shard.lru.begin();
+    if (shard.lru.size() > MAX_PER_SHARD) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+}
+
+// 对外接口：入队拿 future，由攒批线程代为推理
 std::vector<float> AIEngine::Predict(const std::vector<float>& inputData) {
-    if (!session_) {
+    if (!loaded_) {
         LOG_ERROR("[AIEngine] Model not loaded!");
         return {};
     }
+    // 🌟 先查结果缓存：命中直接返回，整条攒批+session Run 都不走
+    std::string key = CacheKey_(inputData);
+    std::vector<float> cached;
+    if (cache_.Get(key, cached)) {
+        Metrics::Instance()->Inc(Metrics::C_AI_CACHE_HITS);
+        return cached;
+    }
+    Metrics::Instance()->Inc(Metrics::C_AI_CACHE_MISSES);
+
+    uint64_t startUs = Metrics::NowUs();
+    std::future<std::vector<float>> result;
+    {
+        std::lock_guard<std::mutex> lock(qmtx_);
+        jobQueue_.emplace_back();
+        jobQueue_.back().input = inputData;
+        result = jobQueue_.back().promise.get_future();
+    }
+    jobCond_.notify_one();
+    std::vector<float> output = result.get(); // 等攒批线程把结果散回来
+    // 上报端到端推理耗时（含攒批窗口等待，调用方感知到的就是这个值）
+    Metrics::Instance()->Observe(Metrics::H_AI_PREDICT_US, Metrics::NowUs() - startUs);
+    // 回填缓存（空结果是失败/关停路径，不缓存）
+    if (!output.empty()) {
+        cache_.Put(key, output, cacheTtlUs_);
+    }
+    return output;
+}
+
+// 攒批线程主循环：
+// 1. 等到至少有一个请求
+// 2. 睡一个攒批窗口 (batchWindowUs_)，让并发请求凑上车
+// 3. 取出一批同宽度的输入，拼成 [batch, width] 张量一次 Run
+// 4. 把输出按行散回各自的 promise
+void AIEngine::BatchLoop_() {
+    while (!stop_) {
+        std::unique_lock<std::mutex> lock(qmtx_);
+        jobCond_.wait(lock, [this] { return stop_ || !jobQueue_.empty(); });
+        if (stop_) { break; }
 
-    // 加锁，确保多个 HTTP 请求打过来时，推理图的状态不乱
-    std::lock_guard<std::mutex> lock(mtx_);
+        // 攒批窗口：放开锁小睡一会，给并发请求留上车时间
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(batchWindowUs_));
+        lock.lock();
 
-    // 1. 定义输入的 Tensor 形状 (假设模型要求输入形状是 [1, 特征数量])
-    std::vector<int64_t> inputDims = {1, static_cast<int64_t>(inputData.size())};
+        // 只合并同宽度的输入（不同特征数的请求不能拼进同一个张量）
+        size_t width = jobQueue_.front().input.size();
+        std::vector<PendingJob> batch;
+        while (!jobQueue_.empty() && batch.size() < maxBatch_ &&
+               jobQueue_.front().input.size() == width) {
+            batch.push_back(std::move(jobQueue_.front()));
+            jobQueue_.pop_front();
+        }
+        lock.unlock();
+
+        // 拼批量输入
+        std::vector<float> flatInput;
+        flatInput.reserve(batch.size() * width);
+        for (auto& job : batch) {
+            flatInput.insert(flatInput.end(), job.input.begin(), job.input.end());
+        }
+
+        // 借出会话跑这一批（RAII 借还，批内复用同一个会话）
+        Ort::Session* sess = nullptr;
+        AISessionRAII raii(&sess, this);
+        std::vector<float> flatOutput =
+            RunSession_(sess, flatInput, static_cast<int64_t>(batch.size()), static_cast<int64_t>(width));
+
+        if (flatOutput.empty() && batch.size() > 1) {
+            // 兜底：个别模型不支持动态 batch 维，退化成逐个推理
+            for (auto& job : batch) {
+                job.promise.set_value(RunSession_(sess, job.input, 1, static_cast<int64_t>(width)));
+            }
+            continue;
+        }
+
+        // 按行散回结果：输出元素数均分给 batch 个请求
+        size_t perJob = batch.empty() ? 0 : flatOutput.size() / batch.size();
+        for (size_t i = 0; i < batch.size(); i++) {
+            std::vector<float> one(flatOutput.begin() + i * perJob,
+                                   flatOutput.begin() + (i + 1) * perJob);
+            batch[i].promise.set_value(std::move(one));
+        }
+    }
+    // 退出前把没跑完的请求放空结果，避免调用方永久阻塞
+    std::lock_guard<std::mutex> lock(qmtx_);
+    while (!jobQueue_.empty()) {
+        jobQueue_.front().promise.set_value({});
+        jobQueue_.pop_front();
+    }
+}
+
+// 核心前向传播逻辑：输入已拼成 [batch, width]，sess 由调用方从池里借出
+std::vector<float> AIEngine::RunSession_(Ort::Session* sess, const std::vector<float>& flatInput,
+                                         int64_t batch, int64_t width) {
+    // 1. 定义输入的 Tensor 形状
+    std::vector<int64_t> inputDims = {batch, width};
 
     // 2. 将 C++ 的 std::vector 包装成 ONNX 认识的 Tensor
     Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
-        memoryInfo_, 
-        const_cast<float*>(inputData.data()), inputData.size(), 
+        memoryInfo_,
+        const_cast<float*>(flatInput.data()), flatInput.size(),
         inputDims.data(), inputDims.size()
     );
 
     // 3. 执行推理 (Run)
     try {
-        auto outputTensors = session_->Run(
+        auto outputTensors = sess->Run(
             Ort::RunOptions{nullptr},
             inputNodeNames_.data(), &inputTensor, 1,
             outputNodeNames_.data(), 1
@@ -75,4 +277,4 @@ std::vector<float> AIEngine::Predict(const std::vector<float>& inputData) {
         LOG_ERROR("[AIEngine] Inference error: %s", e.what());
         return {};
     }
-}
\ No newline at end of file
+}
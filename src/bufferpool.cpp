@@ -0,0 +1,84 @@
+#include "bufferpool.h"
+#include <string.h> // memset
+
+// 各级块大小和空闲链表上限：4K×4096 + 16K×1024 + 64K×256 ≈ 48MB 封顶
+const size_t BufferPool::CLASS_SIZE[BufferPool::CLASS_CNT] = {4096, 16384, 65536};
+const size_t BufferPool::MAX_FREE[BufferPool::CLASS_CNT] = {4096, 1024, 256};
+
+BufferPool *BufferPool::Instance()
+{
+    static BufferPool pool;
+    return &pool;
+} // 单例模式，获取唯一实例
+
+BufferPool::~BufferPool()
+{
+    for (int c = 0; c < CLASS_CNT; c++)
+    {
+        for (char *chunk : free_[c])
+        {
+            delete[] chunk;
+        }
+    }
+}
+
+// 启动期预热：填满各级空闲链表并触碰每一页（memset 把虚拟页变成真实页）
+// 只在 WebServer 构造函数里单线程调一次，锁开销无所谓
+void BufferPool::Prewarm(size_t chunksPerClass)
+{
+    for (int c = 0; c < CLASS_CNT; c++)
+    {
+        size_t target = chunksPerClass < MAX_FREE[c] ? chunksPerClass : MAX_FREE[c];
+        std::lock_guard<std::mutex> lock(mtx_[c]);
+        while (free_[c].size() < target)
+        {
+            char *chunk = new char[CLASS_SIZE[c]];
+            memset(chunk, 0, CLASS_SIZE[c]);
+            free_[c].push_back(chunk);
+        }
+    }
+}
+
+char *BufferPool::Acquire(size_t need, size_t *cap)
+{
+    for (int c = 0; c < CLASS_CNT; c++)
+    {
+        if (need <= CLASS_SIZE[c])
+        {
+            *cap = CLASS_SIZE[c];
+            {
+                std::lock_guard<std::mutex> lock(mtx_[c]);
+                if (!free_[c].empty())
+                {
+                    char *chunk = free_[c].back();
+                    free_[c].pop_back();
+                    return chunk;
+                }
+            }
+            // 池子空了才真正分配（预热后不会走到这）
+            return new char[CLASS_SIZE[c]];
+        }
+    }
+    // 超大块：不进池子，按需分配按需释放
+    *cap = need;
+    return new char[need];
+}
+
+void BufferPool::Release(char *chunk, size_t cap)
+{
+    if (!chunk) return;
+    for (int c = 0; c < CLASS_CNT; c++)
+    {
+        if (cap == CLASS_SIZE[c])
+        {
+            std::lock_guard<std::mutex> lock(mtx_[c]);
+            if (free_[c].size() < MAX_FREE[c])
+            {
+                free_[c].push_back(chunk);
+                return;
+            }
+            break; // 链表满：直接释放，封顶常驻内存
+        }
+    }
+    delete[] chunk; // 超大块或超额块
+}
@@ -0,0 +1,117 @@
+#include "fdpass.h"
+#include "log.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// 发送端：bind + listen 在 path 上，poll 等接收方上门，
+// 一条 sendmsg 把全部监听 fd 塞进 SCM_RIGHTS 辅助数据
+bool FdPass::Send(const char *path, const std::vector<int> &fds, int timeoutMS)
+{
+    if (fds.empty() || (int)fds.size() > MAX_FDS) { return false; }
+
+    int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv < 0) { return false; }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path); // 上一次异常退出的残留 socket 文件
+    if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(srv, 1) < 0)
+    {
+        LOG_ERROR("FdPass: bind/listen %s failed: %s", path, strerror(errno));
+        close(srv);
+        return false;
+    }
+
+    // 等新进程上门取货（drain 窗口内没人来就算了，老进程照常退出）
+    struct pollfd pfd = {srv, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMS) <= 0)
+    {
+        close(srv);
+        unlink(path);
+        return false;
+    }
+    int conn = accept(srv, nullptr, nullptr);
+    close(srv);
+    unlink(path);
+    if (conn < 0) { return false; }
+
+    // 数据体只有一个字节（fd 个数），真正的货在辅助数据里
+    char count = (char)fds.size();
+    struct iovec iov = {&count, 1};
+    char cbuf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    memset(cbuf, 0, sizeof(cbuf));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    bool ok = sendmsg(conn, &msg, 0) == 1;
+    close(conn);
+    if (!ok)
+    {
+        LOG_ERROR("FdPass: sendmsg failed: %s", strerror(errno));
+    }
+    return ok;
+}
+
+// 接收端：connect 不上（没有老进程在 drain）是正常冷启动，静默返回 false
+bool FdPass::Recv(const char *path, std::vector<int> &fds)
+{
+    int conn = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (conn < 0) { return false; }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (connect(conn, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(conn);
+        return false;
+    }
+
+    char count = 0;
+    struct iovec iov = {&count, 1};
+    char cbuf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    if (recvmsg(conn, &msg, 0) != 1)
+    {
+        close(conn);
+        return false;
+    }
+    close(conn);
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+        int n = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        const int *data = (const int *)CMSG_DATA(cmsg);
+        for (int i = 0; i < n; i++)
+        {
+            fds.push_back(data[i]);
+        }
+    }
+    return !fds.empty();
+}
@@ -0,0 +1,211 @@
+#include "filecache.h"
+#include "log.h"
+#include <fcntl.h>  // open
+#include <unistd.h> // close, pread
+#include <cstring>  // memset
+#include <zlib.h>   // gzip 预压缩
+#ifdef ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+// 最后一个引用释放时关闭 fd（可能晚于被 LRU 淘汰的时刻）
+FileCache::Entry::~Entry()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+FileCache *FileCache::Instance()
+{
+    static FileCache cache;
+    return &cache;
+} // 单例模式，获取唯一实例
+
+void FileCache::SetCapacity(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    maxBytes_ = maxBytes;
+    Evict_();
+}
+
+// 打开文件并建立缓存条目（调用方持锁）
+std::shared_ptr<FileCache::Entry> FileCache::OpenEntry_(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) < 0 || S_ISDIR(st.st_mode))
+    {
+        return nullptr; // 不存在或是目录
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->path = path;
+    entry->fd = fd;
+    entry->st = st;
+    entry->lastCheck = time(nullptr);
+    return entry;
+}
+
+// 把超出容量的冷条目踢出去（调用方持锁）
+// 注意：只是移出缓存结构，真正 close 由 shared_ptr 在最后一个使用者释放时做
+void FileCache::Evict_()
+{
+    while (totalBytes_ > maxBytes_ && !lru_.empty())
+    {
+        auto &victim = lru_.back();
+        totalBytes_ -= victim->charged; // 按实际入账数回退（含变体字节）
+        cache_.erase(victim->path);
+        lru_.pop_back();
+    }
+}
+
+FileCache::Handle FileCache::Get(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = cache_.find(path);
+    if (it != cache_.end())
+    {
+        std::shared_ptr<Entry> entry = *it->second;
+        // mtime 失效校验：每秒最多重新 stat 一次，避免又退化成每请求一次 stat
+        time_t now = time(nullptr);
+        if (now != entry->lastCheck)
+        {
+            struct stat st;
+            if (stat(path.c_str(), &st) < 0 || st.st_mtime != entry->st.st_mtime ||
+                st.st_size != entry->st.st_size)
+            {
+                // 文件被改过或没了：作废旧条目重新打开
+                totalBytes_ -= entry->charged;
+                lru_.erase(it->second);
+                cache_.erase(it);
+                entry = OpenEntry_(path);
+                if (!entry) { return Handle(); }
+                lru_.push_front(entry);
+                cache_[path] = lru_.begin();
+                entry->charged = entry->st.st_size;
+                totalBytes_ += entry->charged;
+                Evict_();
+                return Handle(entry);
+            }
+            entry->lastCheck = now;
+        }
+        // 命中：提到 LRU 链表头
+        lru_.splice(lru_.begin(), lru_, it->second);
+        it->second = lru_.begin();
+        return Handle(entry);
+    }
+
+    // 未命中：打开并放入缓存
+    std::shared_ptr<Entry> entry = OpenEntry_(path);
+    if (!entry)
+    {
+        return Handle();
+    }
+    lru_.push_front(entry);
+    cache_[path] = lru_.begin();
+    entry->charged = entry->st.st_size;
+    totalBytes_ += entry->charged;
+    Evict_();
+    return Handle(entry);
+}
+
+// 从 fd 读出整个文件并压缩（锁外执行，压缩很贵，不能压在缓存大锁里）
+std::shared_ptr<std::vector<char>> FileCache::Compress_(const Entry &entry, Encoding enc)
+{
+    size_t rawSize = entry.st.st_size;
+    std::vector<char> raw(rawSize);
+    size_t got = 0;
+    while (got < rawSize)
+    {
+        ssize_t n = pread(entry.fd, raw.data() + got, rawSize - got, got);
+        if (n <= 0) { return nullptr; }
+        got += n;
+    }
+
+    auto out = std::make_shared<std::vector<char>>();
+    if (enc == GZIP)
+    {
+        // zlib deflate，windowBits 15+16 表示带 gzip 头
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return nullptr;
+        }
+        out->resize(deflateBound(&zs, rawSize));
+        zs.next_in = reinterpret_cast<Bytef *>(raw.data());
+        zs.avail_in = rawSize;
+        zs.next_out = reinterpret_cast<Bytef *>(out->data());
+        zs.avail_out = out->size();
+        int ret = deflate(&zs, Z_FINISH);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END) { return nullptr; }
+        out->resize(zs.total_out);
+    }
+    else // BR
+    {
+#ifdef ENABLE_BROTLI
+        size_t outSize = BrotliEncoderMaxCompressedSize(rawSize);
+        out->resize(outSize);
+        if (!BrotliEncoderCompress(5 /* quality */, 22 /* lgwin */, BROTLI_MODE_TEXT,
+                                   rawSize, reinterpret_cast<const uint8_t *>(raw.data()),
+                                   &outSize, reinterpret_cast<uint8_t *>(out->data())))
+        {
+            return nullptr;
+        }
+        out->resize(outSize);
+#else
+        return nullptr; // 没编译 brotli 支持
+#endif
+    }
+
+    // 压不小反而变大就没意义，直接发原文
+    if (out->size() >= rawSize) { return nullptr; }
+    return out;
+}
+
+// 取预压缩变体：首次请求时懒构建，之后直接命中缓存字节
+std::shared_ptr<std::vector<char>> FileCache::GetVariant(const Handle &handle, Encoding enc)
+{
+    if (!handle.Valid() || enc >= ENCODING_CNT) { return nullptr; }
+    const std::shared_ptr<Entry> &entry = handle.Raw();
+    if (static_cast<size_t>(entry->st.st_size) > MAX_COMPRESS_BYTES ||
+        entry->st.st_size == 0)
+    {
+        return nullptr; // 太大/空文件不压
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (entry->variants[enc]) { return entry->variants[enc]; }
+        if (entry->variantFailed[enc]) { return nullptr; }
+    }
+    // 锁外压缩：偶尔两个线程撞车重复压同一个文件，代价可接受
+    auto compressed = Compress_(*entry, enc);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (compressed)
+    {
+        if (!entry->variants[enc])
+        {
+            entry->variants[enc] = compressed;
+            // 变体字节也计入 LRU 容量——但只在条目还在缓存里时入账：
+            // 压缩是锁外做的，期间条目可能已被淘汰/失效（账已回退），
+            // 给出局者记账就没人来退了
+            auto it = cache_.find(entry->path);
+            if (it != cache_.end() && *it->second == entry)
+            {
+                entry->charged += compressed->size();
+                totalBytes_ += compressed->size();
+                Evict_();
+            }
+        }
+        return entry->variants[enc];
+    }
+    entry->variantFailed[enc] = true;
+    return nullptr;
+}
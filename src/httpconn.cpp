@@ -1,28 +1,34 @@
 #include "httpconn.h"
 #include "log.h"
-#include <sys/mman.h>
 #include <iostream>
 #include <cstring>
 #include <cassert>
-#include <regex>
 #include <fcntl.h>   // open
 #include <unistd.h>  // close
 #include <sys/stat.h>
-#include <sys/mman.h>
+#include <sys/sendfile.h> // sendfile 零拷贝
+#include <netinet/tcp.h>  // TCP_CORK
 #include "ai_engine.h" // 【新增】引入大脑
+#include "responsebuilder.h" // 【新增】响应头构造器
+#include "metrics.h" // 【新增】请求延迟打点 + /metrics 端点
+#include "router.h"  // 【新增】O(1) 路由分发表
+#include "simd_scan.h" // 【新增】SIMD 字节扫描内核（CRLF 查找 / 头匹配）
 
 using namespace std;
 
 const char *HttpConn::srcDir_ = nullptr;
 std::atomic<int> HttpConn::userCount_(0);
 bool HttpConn::isET = true;
+std::atomic<bool> HttpConn::serverWarm_(false);
 
 HttpConn::HttpConn()
 {
     fd_ = -1;
     addr_ = {0};
     isClose_ = true;
-    file_ = nullptr;
+    fileFd_ = -1;
+    fileOff_ = 0;
+    fileLen_ = 0;
     iovCnt_ = 0;
     memset(iov_, 0, sizeof(iov_));
 }
@@ -40,22 +46,44 @@ void HttpConn::Init(int fd, const sockaddr_in &addr)
 
     // 初始化 HTTP 状态变量
     isKeepAlive_ = false;
-    file_ = nullptr;
+    contentLength_ = 0;
+    acceptGzip_ = false;
+    acceptBr_ = false;
+    hasRange_ = false;
+    rangeStart_ = 0;
+    rangeEnd_ = 0;
+    fileHandle_.Release();
+    bodyData_.reset();
+    fileFd_ = -1;
+    fileOff_ = 0;
+    fileLen_ = 0;
     fileStat_ = {0};
+    readDoneUs_ = 0;
+    lastActiveUs_ = Metrics::NowUs();
+    pendingDbHandler_ = nullptr;
+    readHint_ = READ_HINT_MIN; // 新连接从小窗口起步，按实际流量再放大
+    trace_.active = false; // 槽位复用：别把上一条连接的残戳当成本连接的样本
+    inFlight_ = false;
+    iovCnt_ = 0;
+    memset(iov_, 0, sizeof(iov_));
+    ResetParse_();
 }
-// 关闭连接：非常重要，要清理 Socket 和 mmap 内存
+// 关闭连接：非常重要，要清理 Socket 和文件句柄
 void HttpConn::Close()
 {
-    // 释放 mmap 映射的内存（零拷贝的清理工作）
-    if (file_)
-    {
-        munmap(file_, fileStat_.st_size);
-        file_ = nullptr;
-    }
+    // 归还文件缓存句柄（fd 归缓存所有，引用归零才真正 close）
+    fileHandle_.Release();
+    bodyData_.reset();
+    fileFd_ = -1;
+    fileLen_ = 0;
     // 关闭 Socket
-    if (!isClose_)
+    // 【修正】用 fd_ 判重而不是 isClose_：解析器的致命错误路径（400/413/431）
+    // 把 isClose_ 当"发完即关"标记提前置位，若据它判重，真正关闭时
+    // 就成了 no-op，fd 和 userCount_ 都漏掉
+    if (fd_ >= 0)
     {
         isClose_ = true;
+        inFlight_ = false;
         close(fd_);
         fd_ = -1;  // 标记已关闭，防止双重 close
         userCount_--;
@@ -65,10 +93,12 @@ void HttpConn::Close()
 // 读接口：封装了 Buffer 的 ReadFd
 ssize_t HttpConn::Read(int *saveErrno)
 {
+    // 追踪打点：worker 任务开始（和出队戳的差就是线程池排队耗时）
+    if (trace_.active && trace_.taskTsc == 0) { trace_.taskTsc = Metrics::NowTsc(); }
     ssize_t bytes_read = 0; // 【修正：用于累加真正读到的字节数】
     while (true)
     {
-        ssize_t len = readBuff_.ReadFd(fd_, saveErrno);
+        ssize_t len = readBuff_.ReadFd(fd_, saveErrno, readHint_);
         if (len <= 0)
         {
             if (*saveErrno == EAGAIN || *saveErrno == EWOULDBLOCK)
@@ -83,18 +113,75 @@ ssize_t HttpConn::Read(int *saveErrno)
             break;
         }
         bytes_read += len; // 累加读到的数据
+
+        // 🌟 自适应窗口调节：读满窗口 → 流量比窗口大，窗口翻倍（封顶
+        // 64K，ET 循环里下一把立即生效，上传很快爬到 64K 直读）；
+        // 远读不满（< 1/4 窗口）→ 折半退回，小请求不再借大块
+        if (static_cast<size_t>(len) >= readHint_)
+        {
+            if (readHint_ < READ_HINT_MAX) { readHint_ *= 2; }
+        }
+        else if (static_cast<size_t>(len) <= readHint_ / 4 && readHint_ > READ_HINT_MIN)
+        {
+            readHint_ /= 2;
+        }
         if (!isET) break;  // 如果不是 ET 模式，读一次就走
     }
+    // 延迟打点起点：记录"读完成"时刻（同一轮请求只记第一次）
+    if (bytes_read > 0)
+    {
+        lastActiveUs_ = Metrics::NowUs();
+        if (readDoneUs_ == 0) { readDoneUs_ = lastActiveUs_; }
+    }
     return bytes_read; // 返回总共读到的字节数
 }
 
-// 写接口：封装了 Buffer 的 WriteFd
+// TCP_CORK 开关：发送文件前打开，响应发完后关闭，
+// 让响应头和文件体在内核里攒成整包（MSS 对齐）发出，避免小包
+void HttpConn::SetCork_(bool on)
+{
+    int optval = on ? 1 : 0;
+    setsockopt(fd_, IPPROTO_TCP, TCP_CORK, &optval, sizeof(optval));
+}
+
+// 单轮写事件里 sendfile 的发送窗口上限：大文件按窗口喂 socket，
+// 发满一个窗口就还回事件循环重新武装 EPOLLOUT，一个 4GB 下载
+// 不会把 reactor/worker 独占到天荒地老，慢速客户端之间保持公平
+static const size_t SENDFILE_CHUNK = 256 * 1024;
+
+// 写接口：响应头走 writev，文件体走 sendfile（内核页缓存 -> socket，零拷贝）
 ssize_t HttpConn::Write(int *saveErrno)
 {
-    ssize_t bytes_write = 0; // 【修正：用于累加真正写出的字节数】
+    ssize_t bytes_write = 0; // 累加真正写出的字节数
+    size_t fileSent = 0;     // 本轮已通过 sendfile 发出的字节数（窗口控制）
+    bool cork = (fileLen_ > 0 && iov_[0].iov_len > 0);
+    if (cork) { SetCork_(true); }
     while (true)
     {
-        ssize_t len = writev(fd_, iov_, iovCnt_);
+        size_t iovBytes = iov_[0].iov_len + iov_[1].iov_len;
+        ssize_t len = 0;
+        if (iovBytes > 0)
+        {
+            // 先把响应头（和可能的内存响应体，比如预压缩变体）发出去
+            len = writev(fd_, iov_, iovCnt_);
+        }
+        else if (fileLen_ > 0)
+        {
+            if (fileSent >= SENDFILE_CHUNK)
+            {
+                break; // 本轮窗口用完，剩余文件体等下一次 EPOLLOUT
+            }
+            // 🌟 零拷贝：sendfile 让内核直接把页缓存写进 socket，
+            //    数据不经过用户空间，offset 由内核推进
+            size_t want = fileLen_ < SENDFILE_CHUNK - fileSent ? fileLen_
+                                                               : SENDFILE_CHUNK - fileSent;
+            len = sendfile(fd_, fileFd_, &fileOff_, want);
+        }
+        else
+        {
+            break; // 数据全发完了
+        }
+
         if (len < 0)
         {
             *saveErrno = errno;
@@ -106,171 +193,484 @@ ssize_t HttpConn::Write(int *saveErrno)
             {
                 continue;
             }
-            if (bytes_write == 0) return -1;
+            if (bytes_write == 0) { if (cork) SetCork_(false); return -1; }
             break;
         }
         if (len == 0) break;
-        
-        bytes_write += len; // 累加发送的字节数
 
-        if (iov_[0].iov_len + iov_[1].iov_len == 0) { break; } // 数据全发完了
+        bytes_write += len; // 累加发送的字节数
 
-        // 调整 iov_ 指针
-        if (static_cast<size_t>(len) > iov_[0].iov_len)
+        if (iovBytes > 0)
         {
-            iov_[1].iov_base = (uint8_t *)iov_[1].iov_base + (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if (iov_[0].iov_len)
+            // 调整 iov_ 指针
+            if (static_cast<size_t>(len) > iov_[0].iov_len)
             {
-                writeBuff_.RetrieveAll();
-                iov_[0].iov_len = 0;
+                iov_[1].iov_base = (uint8_t *)iov_[1].iov_base + (len - iov_[0].iov_len);
+                iov_[1].iov_len -= (len - iov_[0].iov_len);
+                if (iov_[0].iov_len)
+                {
+                    writeBuff_.RetrieveAll();
+                    iov_[0].iov_len = 0;
+                }
+            }
+            else
+            {
+                iov_[0].iov_base = (uint8_t *)iov_[0].iov_base + len;
+                iov_[0].iov_len -= len;
+                writeBuff_.Retrieve(len);
             }
         }
         else
         {
-            iov_[0].iov_base = (uint8_t *)iov_[0].iov_base + len;
-            iov_[0].iov_len -= len;
-            writeBuff_.Retrieve(len);
+            fileLen_ -= len; // sendfile 发出的部分
+            fileSent += len;
         }
 
         if (!isET && ToWriteBytes() < 10240) break; // 退出条件
     }
+    if (cork) { SetCork_(false); } // 解除 CORK，把攒着的尾包冲出去
+    // 文件体发完了就可以归还缓存句柄 / 释放内存体
+    if (fileFd_ >= 0 && fileLen_ == 0)
+    {
+        fileHandle_.Release();
+        fileFd_ = -1;
+    }
+    if (bodyData_ && iov_[1].iov_len == 0)
+    {
+        bodyData_.reset();
+    }
+    if (bytes_write > 0) { lastActiveUs_ = Metrics::NowUs(); }
+    // 延迟打点终点：整条响应发完，上报"读完成 -> 写完成"耗时
+    if (readDoneUs_ != 0 && ToWriteBytes() == 0)
+    {
+        Metrics::Instance()->Observe(Metrics::H_REQUEST_US, Metrics::NowUs() - readDoneUs_);
+        readDoneUs_ = 0;
+    }
+    // 抽样追踪终点：末字节落盘，整条拆成四段上报 per-stage 直方图
+    if (trace_.active && ToWriteBytes() == 0) { TraceFlush_(); }
     return bytes_write; // 返回总共发出的字节数
 }
 
+// 空闲内存回收：定时扫描从 reactor 线程调进来。
+// 【修正】"空闲"必须用 inFlight_ 判断而不能只看 lastActiveUs_：
+// 空闲 >5s 的连接来数据时 oneshot 事件先出队、任务进线程池排队，
+// lastActiveUs_ 要等 worker 跑到 Read() 才更新——这个窗口里扫描
+// 不能碰它的缓冲。DB 泊车的连接同理（事件熄火但 DB 线程在写响应）
+void HttpConn::ShrinkIfIdle(uint64_t nowUs, uint64_t idleUs)
+{
+    if (isClose_) { return; }
+    if (inFlight_ || HasPendingDb()) { return; }
+    if (nowUs - lastActiveUs_ < idleUs) { return; }
+    // 有在途响应或半截请求的不收（Shrink 对有数据的缓冲本身也是 no-op）
+    if (ToWriteBytes() > 0 || fileFd_ >= 0 || bodyData_) { return; }
+    readBuff_.Shrink();
+    writeBuff_.Shrink();
+    fileHandle_.Release();
+    if (body_.capacity() > 0) { std::string().swap(body_); } // 释放大 POST 撑起的容量
+    readHint_ = READ_HINT_MIN; // 空闲够久，读窗口也退回小档（上一单的大流量不代表下一单）
+}
+
 // 处理请求 (解析 HTTP 请求，生成响应)
+// 🌟 面试亮点：HTTP/1.1 流水线 (pipelining)
+// 一次读事件里可能攒着多个完整请求（客户端 pipeline 或批量健康检查），
+// 这里循环解析并响应缓冲区里的每一个完整请求，所有响应追加进 writeBuff_
+// 后只武装一次 EPOLLOUT；没解析完的半个请求原样留在 readBuff_ 里等下次读
 bool HttpConn::Process() {
-    // 1. 从 readBuff_ 中取出所有收到的数据
-    if(readBuff_.ReadAbleBytes() <= 0) {
+    bool hasResponse = false;
+    while(true) {
+        // 上一条响应带文件体 (sendfile) 或内存体 (预压缩变体)：
+        // 必须等它发完才能拼接后续响应，剩余的流水线请求留在 readBuff_ 里，
+        // 写完后 OnProcess 会再进来
+        if(fileFd_ >= 0 || bodyData_) { break; }
+
+        // 驱动增量状态机：半包时停止，等下一次读
+        if(!ParseFromBuffer_()) { break; }
+
+        // 一个完整请求已就绪，处理业务并为下一个请求复位状态机
+        // （追踪打点：解析完成。流水线多请求时只记第一个）
+        if(trace_.active && trace_.parseTsc == 0) { trace_.parseTsc = Metrics::NowTsc(); }
+        ResetParse_();
+        if(isClose_) { hasResponse = true; break; } // 413 等致命错误：发完就关
+
+        HandleRequest_();
+        Metrics::Instance()->Inc(Metrics::C_HTTP_REQUESTS);
+        // DB 绑定路由：处理函数被泊车，响应还没写出来，整条流水线停在这里
+        // 等 DB 线程完成；后续流水线请求留在 readBuff_ 里
+        if(pendingDbHandler_) { return false; }
+        hasResponse = true;
+
+        if(readBuff_.ReadAbleBytes() == 0) { break; } // 缓冲区干净了
+    }
+
+    if(!hasResponse) {
         return false;
     }
-    std::string requestData = readBuff_.RetrieveAllToStr();
+    // 所有响应攒在 writeBuff_ 里，一次性设置 iov 并武装 EPOLLOUT
+    FinishResponse_();
+    return true;
+}
 
-    // 2. 按行解析 (以 \r\n 为分隔符)
-    size_t lineEnd = requestData.find("\r\n");
-    if(lineEnd == std::string::npos) {
-        return false; // 请求行不完整
+// 把攒在 writeBuff_（和可能的内存体）里的响应装进 iov
+void HttpConn::FinishResponse_() {
+    iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
+    iov_[0].iov_len = writeBuff_.ReadAbleBytes();
+    iovCnt_ = 1;
+    if(bodyData_) {
+        // 内存响应体（预压缩变体）跟在所有响应头后面，走 writev 第二块
+        iov_[1].iov_base = bodyData_->data();
+        iov_[1].iov_len = bodyData_->size();
+        iovCnt_ = 2;
     }
+    // 追踪打点：响应组装完成（DB 泊车的请求从 RunPendingDb 进来，
+    // 这段自然涵盖数据库往返）
+    if(trace_.active && trace_.builtTsc == 0) { trace_.builtTsc = Metrics::NowTsc(); }
+}
+
+// 末字节写出：抽中的请求在这里把四段差值换算成微秒一并上报。
+// 半路出错没凑齐的戳只报前面完整的段；上报完熄火，等下一次被抽中
+void HttpConn::TraceFlush_()
+{
+    uint64_t endTsc = Metrics::NowTsc();
+    trace_.active = false;
+    if(trace_.taskTsc < trace_.deqTsc) { return; } // 戳没打上或时钟倒走，整条作废
+    Metrics::Instance()->Observe(Metrics::H_STAGE_QUEUE_US,
+                                 Metrics::TscToUs(trace_.taskTsc - trace_.deqTsc));
+    if(trace_.parseTsc < trace_.taskTsc) { return; }
+    Metrics::Instance()->Observe(Metrics::H_STAGE_PARSE_US,
+                                 Metrics::TscToUs(trace_.parseTsc - trace_.taskTsc));
+    if(trace_.builtTsc < trace_.parseTsc) { return; }
+    Metrics::Instance()->Observe(Metrics::H_STAGE_BUILD_US,
+                                 Metrics::TscToUs(trace_.builtTsc - trace_.parseTsc));
+    if(endTsc < trace_.builtTsc) { return; }
+    Metrics::Instance()->Observe(Metrics::H_STAGE_WRITE_US,
+                                 Metrics::TscToUs(endTsc - trace_.builtTsc));
+}
 
-    // 2.1 解析请求行 (如: GET /index.html HTTP/1.1)
-    std::string requestLine = requestData.substr(0, lineEnd);
-    if(!ParseRequestLine_(requestLine)) {
-        return false; // 请求行解析失败 
+// 在专职 DB 线程上执行泊车的处理函数：做数据库往返、把响应追加进
+// writeBuff_，然后装 iov。之后由 WebServer 经 PostOp_ 唤醒 reactor
+// 武装 EPOLLOUT，把连接交还给事件循环
+void HttpConn::RunPendingDb() {
+    Router::Handler handler = pendingDbHandler_;
+    pendingDbHandler_ = nullptr;
+    if(handler) {
+        (this->*handler)();
     }
+    FinishResponse_();
+}
 
-    // 2.2 解析请求头 (循环查找 \r\n)
-    size_t headerStart = lineEnd + 2; // 跳过 \r\n
-    // 【修正：增加括号，保证先赋值再比较】
-    while((lineEnd = requestData.find("\r\n", headerStart)) != std::string::npos) {
-        std::string headerLine = requestData.substr(headerStart, lineEnd - headerStart);
-        if(headerLine.empty()) {
-            // 遇到空行，说明请求头结束了，后面紧跟着的是 Body
-            headerStart = lineEnd + 2; 
-            break;
+// 启动期注册所有 API 端点：静态文件不注册，留作默认路由
+void HttpConn::RegisterRoutes()
+{
+    Router::Instance()->Register("GET", "/metrics", &HttpConn::HandleMetrics_);
+    Router::Instance()->Register("GET", "/healthz", &HttpConn::HandleHealth_);
+    Router::Instance()->Register("POST", "/api/predict", &HttpConn::HandlePredict_);
+    // 登录要做 MySQL 往返：标记 DB 绑定，泊车到专职 DB 线程池执行，
+    // 数据库慢的时候 worker 池不陪葬，静态文件照常响应
+    Router::Instance()->Register("POST", "/login", &HttpConn::HandleLogin_,
+                                 true /* dbBound */);
+}
+
+// 处理一个解析完毕的请求：一次 O(1) 路由查找分发到处理函数，
+// 查不到走静态文件默认路由。响应只追加进 writeBuff_，
+// iov 的设置统一放在 Process() 出口（流水线下多个响应共享一块写缓冲）
+void HttpConn::HandleRequest_() {
+    bool dbBound = false;
+    Router::Handler handler = Router::Instance()->Route(method_, path_, &dbBound);
+    if(handler) {
+        if(dbBound) {
+            pendingDbHandler_ = handler; // 泊车：由 DB 线程池执行
+            return;
         }
-        ParseHeader_(headerLine);
-        headerStart = lineEnd + 2; // 继续查找下一行
+        (this->*handler)();
+        return;
     }
+    // 默认路由：静态文件（响应头进 writeBuff_，文件体走 sendfile）
+    MakeResponse_();
+}
 
-    // 2.3 解析请求体 (比如 POST 提交的表单数据)
-    // 注意：这段代码必须在 while 循环的外面！
-    if(headerStart < requestData.size()) {
-        std::string body = requestData.substr(headerStart);
-        ParseBody_(body);
+// 【新增】监控端点：聚合各分片计数器/直方图，输出 Prometheus 文本
+void HttpConn::HandleMetrics_()
+{
+    std::string text = Metrics::Instance()->Render();
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t headerLen = ResponseBuilder::BuildHeader(
+        header, 200, isKeepAlive_, text.size(), "text/plain; version=0.0.4");
+    writeBuff_.Append(header, headerLen);
+    writeBuff_.Append(text);
+}
+
+// 【新增】LB 健康检查：预热阶段（缓冲池/文件缓存/AI 引擎还没摸热）返回 503，
+// 负载均衡此时不把流量切过来；warm-start 跑完后恒定 200
+void HttpConn::HandleHealth_()
+{
+    bool warm = serverWarm_.load(std::memory_order_acquire);
+    const char *text = warm ? "ok\n" : "warming up\n";
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t headerLen = ResponseBuilder::BuildHeader(
+        header, warm ? 200 : 503, isKeepAlive_, strlen(text), "text/plain");
+    writeBuff_.Append(header, headerLen);
+    writeBuff_.Append(text, strlen(text));
+}
+
+// 🌟【新增】AI 智能接口
+void HttpConn::HandlePredict_()
+{
+    // 1. 解析用户输入的数字 (这里假设 Body 里就是一个纯数字字符串)
+    float inputVal = 0.0f;
+    try {
+        inputVal = std::stof(body_); // string -> float
+    } catch (...) {
+        inputVal = 0.0f; // 解析失败给个默认值
     }
-    
-    // 🌟【新增】AI 智能接口拦截逻辑
-    // ==========================================================
-    if (method_ == "POST" && path_ == "/api/predict") {
-        // 1. 解析用户输入的数字 (这里假设 Body 里就是一个纯数字字符串)
-        float inputVal = 0.0f;
-        try {
-            inputVal = std::stof(body_); // string -> float
-        } catch (...) {
-            inputVal = 0.0f; // 解析失败给个默认值
+
+    // 2. 调用 AI 引擎进行推理
+    std::vector<float> inputVec = { inputVal };
+    std::vector<float> outputVec = AIEngine::Instance()->Predict(inputVec);
+
+    // 3. 构造响应内容 (这里为了简单，直接返回计算结果的字符串)
+    std::string responseBody = "Result: " + std::to_string(outputVec.empty() ? 0.0f : outputVec[0]);
+
+    // 4. 组装 HTTP 响应报文：响应头一次性栈上拼好再 memcpy 进写缓冲
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t headerLen = ResponseBuilder::BuildHeader(
+        header, 200, true /* 保持长连接 */, responseBody.size(), "text/plain");
+    writeBuff_.Append(header, headerLen);
+    writeBuff_.Append(responseBody);
+}
+// 状态机主循环：逐行消费 readBuff_，状态跨多次 Read 保留
+// 返回 true 表示凑齐了一个完整请求（parseState_ == FINISH）
+bool HttpConn::ParseFromBuffer_() {
+    while(parseState_ != FINISH) {
+        const char* begin = readBuff_.Peek();
+        const char* end = begin + readBuff_.ReadAbleBytes();
+
+        if(parseState_ == BODY) {
+            // 🌟 按 Content-Length 精确收体：只消费声明长度内的字节，
+            // 跨多次读增量累积；体后面的字节留在缓冲区（可能是下一个流水线请求）
+            size_t need = contentLength_ > body_.size() ? contentLength_ - body_.size() : 0;
+            if(need > 0) {
+                size_t avail = end - begin;
+                size_t take = avail < need ? avail : need;
+                body_.append(begin, take);
+                readBuff_.Retrieve(take);
+                if(take < need) {
+                    return false; // 体还没收全，返回"还差数据"等下一次读
+                }
+            }
+            parseState_ = FINISH;
+            break;
+        }
+
+        // REQUEST_LINE / HEADERS 都按行推进
+        // 🌟 SIMD 找行尾：一条掩码指令同时验证 16/32 字节里的 "\r\n" 对
+        const char* lineEnd = SimdScan::FindCRLF(begin, end);
+        if(lineEnd == nullptr) {
+            // 防御：恶意超长请求头直接 431 并关闭，避免无限囤积
+            // 【修正】必须消费整个缓冲并标记关闭：只置 FINISH 的话这批
+            // 字节原样留在 readBuff_ 里，Process 的流水线循环会在同一
+            // 分支上空转到天荒地老（worker 忙死 + writeBuff_ 无限膨胀）
+            if(readBuff_.ReadAbleBytes() > MAX_REQUEST_HEADER_SIZE) {
+                LOG_WARN("Request header too large: %zu bytes", readBuff_.ReadAbleBytes());
+                char header[ResponseBuilder::MAX_HEADER_LEN];
+                size_t headerLen = ResponseBuilder::BuildHeader(header, 431, false, 0);
+                writeBuff_.Append(header, headerLen);
+                isKeepAlive_ = false;
+                isClose_ = true;
+                readBuff_.RetrieveAll();
+                parseState_ = FINISH;
+                return true;
+            }
+            return false; // 半行数据，等下一次读
         }
 
-        // 2. 调用 AI 引擎进行推理
-        std::vector<float> inputVec = { inputVal };
-        std::vector<float> outputVec = AIEngine::Instance()->Predict(inputVec);
-        
-        // 3. 构造响应内容 (这里为了简单，直接返回计算结果的字符串)
-        std::string responseBody = "Result: " + std::to_string(outputVec.empty() ? 0.0f : outputVec[0]);
-
-        // 4. 组装 HTTP 响应报文
-        writeBuff_.Append("HTTP/1.1 200 OK\r\n");
-        writeBuff_.Append("Content-Type: text/plain\r\n");
-        writeBuff_.Append("Content-Length: " + std::to_string(responseBody.size()) + "\r\n");
-        writeBuff_.Append("Connection: keep-alive\r\n\r\n"); // 保持长连接
-        writeBuff_.Append(responseBody);
-
-        // 5. 设置 writev 的指针
-        iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
-        iov_[0].iov_len = writeBuff_.ReadAbleBytes();
-        iovCnt_ = 1; // 只需要发送 writeBuff_ 里的数据，没有文件映射
-        
-        return true; // 处理完毕，直接返回，不走后面的静态文件逻辑
+        if(parseState_ == REQUEST_LINE) {
+            if(!ParseRequestLine_(begin, lineEnd)) {
+                // 【修正】请求行非法：直接 400 并关闭，不能再丢给路由——
+                // method_/path_ 还是上一个 keep-alive 请求的残留，按残留
+                // 状态路由会把上一个资源当新响应 200 重发一遍
+                char header[ResponseBuilder::MAX_HEADER_LEN];
+                size_t headerLen = ResponseBuilder::BuildHeader(header, 400, false, 0);
+                writeBuff_.Append(header, headerLen);
+                isKeepAlive_ = false;
+                isClose_ = true;
+                readBuff_.RetrieveUntil(lineEnd + 2);
+                parseState_ = FINISH;
+                return true;
+            }
+            // 新请求开始：清掉上一个请求残留的体、体长度、Range、
+            // 长连接标记和编码协商标记
+            body_.clear();
+            contentLength_ = 0;
+            isKeepAlive_ = false;
+            hasRange_ = false;
+            rangeStart_ = 0;
+            rangeEnd_ = 0;
+            // 【修正】Accept-Encoding 是逐请求声明的：不清的话，长连接上
+            // 后面一个没带这个头的请求会沿用前一个请求的协商结果，
+            // 收到一份它没声明能解的 gzip/br 变体
+            acceptGzip_ = false;
+            acceptBr_ = false;
+            parseState_ = HEADERS;
+        }
+        else { // HEADERS
+            if(!ParseHeaderLine_(begin, lineEnd)) {
+                // 空行：请求头结束
+                // 🌟 早拒：超限的体在收第一个字节之前就打回 413，
+                //    不让恶意大上传把内存和带宽都吃掉
+                if(contentLength_ > MAX_REQUEST_BODY_SIZE) {
+                    LOG_WARN("Request body too large: %zu bytes (declared)", contentLength_);
+                    char header[ResponseBuilder::MAX_HEADER_LEN];
+                    size_t headerLen = ResponseBuilder::BuildHeader(header, 413, false, 0);
+                    writeBuff_.Append(header, headerLen);
+                    isKeepAlive_ = false; // 响应头写的是 close，发完走关闭路径
+                    isClose_ = true;
+                    readBuff_.RetrieveUntil(lineEnd + 2);
+                    parseState_ = FINISH;
+                    return true;
+                }
+                // 一次性预留体空间，避免慢发送方多次触发 string 扩容重拷
+                if(contentLength_ > 0) {
+                    body_.reserve(contentLength_);
+                }
+                parseState_ = BODY;
+            }
+        }
+        readBuff_.RetrieveUntil(lineEnd + 2); // 消费这一行（含 \r\n）
     }
-    // ==========================================================
-    // 3. 根据解析结果生成 HTTP 响应 (设置 iov_ 指向响应头和文件内容)
-    MakeResponse_();
     return true;
 }
-// 解析请求行：使用正则表达式提取 Method, Path, Version
-bool HttpConn::ParseRequestLine_(const std::string& line){
-    std::regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    std::smatch subMatch;
-    if(std::regex_match(line, subMatch, patten)) {
-        method_ = subMatch[1];
-        path_ = subMatch[2];
-        version_ = subMatch[3];
-        if(path_ == "/") {
-            path_ = "/index.html";
-        }
-        return true;
+
+// 解析请求行：手写切分提取 Method, Path, Version (如: GET /index.html HTTP/1.1)
+bool HttpConn::ParseRequestLine_(const char* begin, const char* end){
+    const char* sp1 = static_cast<const char*>(memchr(begin, ' ', end - begin));
+    if(sp1 == nullptr) return false;
+    const char* sp2 = static_cast<const char*>(memchr(sp1 + 1, ' ', end - sp1 - 1));
+    if(sp2 == nullptr) return false;
+    // 版本部分必须以 "HTTP/" 开头
+    if(end - sp2 - 1 < 5 || strncmp(sp2 + 1, "HTTP/", 5) != 0) return false;
+
+    method_.assign(begin, sp1 - begin);
+    path_.assign(sp1 + 1, sp2 - sp1 - 1);
+    version_.assign(sp2 + 6, end - sp2 - 6);
+    if(path_ == "/") {
+        path_ = "/index.html";
     }
-    return false;
+    return true;
 }
 
-// 解析请求头：重点关注 Connection 字段，判断是否是长连接
-void HttpConn::ParseHeader_(const std::string& line){
-    std::regex patten("^([^:]*): ?(.*)$");
-    std::smatch subMatch;
-    if(std::regex_match(line, subMatch, patten)) {
-        std::string headerName = subMatch[1];
-        std::string headerValue = subMatch[2];
-        if(headerName == "Connection" && headerValue == "keep-alive") {
+// 解析单行请求头：重点关注 Connection 字段，判断是否是长连接
+// 返回 false 表示遇到空行（头部结束），true 表示还在头部
+bool HttpConn::ParseHeaderLine_(const char* begin, const char* end){
+    if(begin == end) {
+        return false; // 空行，请求头结束
+    }
+    const char* colon = static_cast<const char*>(memchr(begin, ':', end - begin));
+    if(colon == nullptr) {
+        return true; // 非法行，跳过
+    }
+    // 跳过冒号后的空格
+    const char* value = colon + 1;
+    while(value < end && *value == ' ') { ++value; }
+
+    // 零拷贝比较：直接在缓冲区字节上做大小写无关匹配，不构造 string
+    // （CaseEq 是向量化的 strncasecmp，≥16 字节的名字一次比一整块）
+    size_t nameLen = colon - begin;
+    if(nameLen == 10 && SimdScan::CaseEq(begin, "Connection", 10)) {
+        if(static_cast<size_t>(end - value) == 10 && SimdScan::CaseEq(value, "keep-alive", 10)) {
             isKeepAlive_ = true;
         }
     }
-        
+    else if(nameLen == 14 && SimdScan::CaseEq(begin, "Content-Length", 14)) {
+        // 值以 \r 结尾，strtoul 遇到非数字自动停，不需要截断拷贝
+        contentLength_ = strtoul(value, nullptr, 10);
+    }
+    else if(nameLen == 5 && SimdScan::CaseEq(begin, "Range", 5)) {
+        // 只认 bytes 单位；多段 Range（带逗号）不支持，忽略后按整文件 200 回
+        if(end - value > 6 && SimdScan::CaseEq(value, "bytes=", 6) &&
+           memchr(value + 6, ',', end - value - 6) == nullptr) {
+            const char* p = value + 6;
+            char* stop = nullptr;
+            if(*p == '-') {
+                // 后缀形式 bytes=-N：取文件末尾 N 字节
+                size_t n = strtoul(p + 1, &stop, 10);
+                if(stop != p + 1 && n > 0) {
+                    hasRange_ = true;
+                    rangeStart_ = SIZE_MAX;
+                    rangeEnd_ = n;
+                }
+            } else {
+                size_t s = strtoul(p, &stop, 10);
+                if(stop != p && stop < end && *stop == '-') {
+                    size_t e = SIZE_MAX; // 开区间：S 到文件末尾
+                    if(stop + 1 < end && stop[1] >= '0' && stop[1] <= '9') {
+                        e = strtoul(stop + 1, nullptr, 10);
+                    }
+                    hasRange_ = true;
+                    rangeStart_ = s;
+                    rangeEnd_ = e;
+                }
+            }
+        }
+    }
+    else if(nameLen == 15 && SimdScan::CaseEq(begin, "Accept-Encoding", 15)) {
+        // 在值里找 "gzip" / "br" 子串（不构造 string，直接扫字节）
+        for(const char* p = value; p + 4 <= end; ++p) {
+            if(strncasecmp(p, "gzip", 4) == 0) { acceptGzip_ = true; break; }
+        }
+        for(const char* p = value; p + 2 <= end; ++p) {
+            if(strncasecmp(p, "br", 2) == 0 &&
+               (p + 2 == end || p[2] == ',' || p[2] == ' ' || p[2] == ';')) {
+                acceptBr_ = true;
+                break;
+            }
+        }
+    }
+    return true;
 }
-// 解析请求体：如果是 POST 登录，这里会调用 SqlConnPool 查数据库
-void HttpConn::ParseBody_(const std::string& line)
+
+// 为下一个请求复位状态机（长连接下同一条连接会解析多个请求）
+void HttpConn::ResetParse_() {
+    parseState_ = REQUEST_LINE;
+}
+
+// 登录接口：调用 SqlConnPool 查数据库（从解析器里挪出来的业务逻辑）
+void HttpConn::HandleLogin_()
 {
-    // 【新增】请求体大小检查（防止 OOM 攻击）
-    if(line.size() > MAX_REQUEST_BODY_SIZE) {
-        LOG_WARN("Request body too large: %zu bytes", line.size());
-        writeBuff_.Append("HTTP/1.1 413 Payload Too Large\r\n");
-        writeBuff_.Append("Content-Length: 0\r\n\r\n");
-        isClose_ = true;
-        return;
+    // 面试亮点：从线程池里取出一个 Worker 线程正在执行这行代码
+    // 我们利用 RAII 自动从连接池拿一个 MySQL 连接
+    MYSQL* sql;
+    SqlConnRAII raii(&sql, SqlConnPool::Instance());
+
+    // 🌟 预编译语句缓存：同一查询形状在这条连接上只 parse/plan 一次，
+    // 之后每次登录都直接 execute（真实业务中在 stmt 上 bind 参数后执行）
+    MYSQL_STMT* stmt = SqlConnPool::Instance()->PreparedStmt(
+        sql, "SELECT password FROM user WHERE username = ? LIMIT 1");
+    if(stmt) {
+        // （此处省略具体的参数绑定和密码校验逻辑，为了保持代码精简）
+        // 真实业务中，会解析 body (如 user=admin&pwd=123)，bind 后 mysql_stmt_execute
+        LOG_DEBUG("[DB] Executing Login check using cached prepared statement.");
     }
-    
-    body_ = line; // 【修正】先保存请求体到成员变量
 
-    // 假设这是一个登录请求，路径是 /login
-    if(method_ == "POST" && path_ == "/login")
-    {
-        // 面试亮点：从线程池里取出一个 Worker 线程正在执行这行代码
-        // 我们利用 RAII 自动从连接池拿一个 MySQL 连接
-        MYSQL* sql;
-        SqlConnRAII(&sql, SqlConnPool::Instance());
-
-        // （此处省略具体的 SQL 账号密码校验逻辑，为了保持代码精简）
-        // 真实业务中，会解析 line (如 user=admin&pwd=123)，然后查库
-        LOG_DEBUG("[DB] Executing Login check using pooled connection.");
+    static const char RESP_BODY[] = "Login OK";
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t headerLen = ResponseBuilder::BuildHeader(
+        header, 200, isKeepAlive_, sizeof(RESP_BODY) - 1, "text/plain");
+    writeBuff_.Append(header, headerLen);
+    writeBuff_.Append(RESP_BODY, sizeof(RESP_BODY) - 1);
+}
+
+// 文本类扩展名才值得压缩（图片/视频本身已压缩，再压是白烧 CPU）
+static bool IsCompressible_(const std::string& path) {
+    static const char* exts[] = {".html", ".htm", ".css", ".js", ".json",
+                                 ".txt", ".svg", ".xml", ".csv"};
+    for(const char* ext : exts) {
+        size_t extLen = strlen(ext);
+        if(path.size() >= extLen &&
+           strcasecmp(path.c_str() + path.size() - extLen, ext) == 0) {
+            return true;
+        }
     }
+    return false;
 }
 
 // 阶段三：生成 HTTP 响应 (零拷贝核心)
@@ -280,54 +680,106 @@ void HttpConn::MakeResponse_()
     // 1. 拼接目标文件的绝对路径
     // srcDir_ 是在 WebServer 启动时设置的，比如 /var/www/html
     std::string targetPath = std::string(srcDir_) + path_;
-    
-    // 2. 检查文件是否存在且可读 (stat 系统调用)
-    if(stat(targetPath.c_str(), &fileStat_) < 0 || S_ISDIR(fileStat_.st_mode)) {
-        // 文件不存在或是目录，返回 404
-        writeBuff_.Append("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
-        // 【修正：统一使用 const_cast 和 Peek()，保持代码风格一致，避免去除 const 带来的隐患】
-        iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
-        iov_[0].iov_len = writeBuff_.ReadAbleBytes();
-        iovCnt_ = 1;
+
+    // 2. 从文件缓存取句柄：热点文件命中时 stat/open 都是记忆化的，零系统调用
+    fileHandle_ = FileCache::Instance()->Get(targetPath);
+    if(!fileHandle_.Valid()) {
+        // 文件不存在或是目录，返回 404（iov 由 Process() 出口统一设置）
+        char header[ResponseBuilder::MAX_HEADER_LEN];
+        size_t headerLen = ResponseBuilder::BuildHeader(header, 404, isKeepAlive_, 0);
+        writeBuff_.Append(header, headerLen);
         return;
     }
+    fileStat_ = fileHandle_.Stat();
 
-    // 3. 文件存在，生成 200 OK 的 HTTP 响应头
-    writeBuff_.Append("HTTP/1.1 200 OK\r\n");
-    if(isKeepAlive_) {
-        writeBuff_.Append("Connection: keep-alive\r\n");
-    } else {
-        writeBuff_.Append("Connection: close\r\n");
-    }
-    writeBuff_.Append("Content-Length: " + std::to_string(fileStat_.st_size) + "\r\n\r\n");
-
-    // 4. 使用 mmap 将文件映射到内存，file_ 指向文件内容的首地址
-    int srcFd = open(targetPath.c_str(), O_RDONLY);
-    if(srcFd < 0) {
-        // 打开文件失败
-        writeBuff_.RetrieveAll();
-        writeBuff_.Append("HTTP/1.1 403 Forbidden\r\n\r\n");
-        iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
-        iov_[0].iov_len = writeBuff_.ReadAbleBytes();
-        iovCnt_ = 1;
+    // 3. Range 请求：按区间切文件体，206 + Content-Range 走 sendfile
+    //    （Range 作用于原始字节，跳过压缩变体协商）
+    if(hasRange_) {
+        size_t total = static_cast<size_t>(fileStat_.st_size);
+        size_t start = 0, last = 0;
+        bool valid = total > 0;
+        if(valid && rangeStart_ == SIZE_MAX) {
+            // 后缀形式：取末尾 rangeEnd_ 字节
+            size_t n = rangeEnd_ < total ? rangeEnd_ : total;
+            start = total - n;
+            last = total - 1;
+        } else if(valid) {
+            start = rangeStart_;
+            last = (rangeEnd_ == SIZE_MAX || rangeEnd_ >= total) ? total - 1 : rangeEnd_;
+            if(start >= total || start > last) { valid = false; }
+        }
+        // 【修正】按最坏情况留足："Content-Range: bytes " 21 字节 + 三个
+        // 最长 20 位的十进制数 + "-" "/" "\r\n" 和结尾 NUL = 86。之前的
+        // 64 会被 TB 级文件（稀疏文件就能造出来）的 13 位偏移量写穿
+        char rangeLine[96];
+        char header[ResponseBuilder::MAX_HEADER_LEN];
+        if(!valid) {
+            // 区间越界：416 + "Content-Range: bytes */total" 告诉客户端文件多大
+            char* rp = rangeLine;
+            memcpy(rp, "Content-Range: bytes */", 23); rp += 23;
+            rp += ResponseBuilder::FormatUint(rp, total);
+            *rp++ = '\r'; *rp++ = '\n'; *rp = '\0';
+            size_t headerLen = ResponseBuilder::BuildHeader(
+                header, 416, isKeepAlive_, 0, nullptr, nullptr, rangeLine);
+            writeBuff_.Append(header, headerLen);
+            fileHandle_.Release();
+            return;
+        }
+        // "Content-Range: bytes S-E/T"
+        char* rp = rangeLine;
+        memcpy(rp, "Content-Range: bytes ", 21); rp += 21;
+        rp += ResponseBuilder::FormatUint(rp, start);
+        *rp++ = '-';
+        rp += ResponseBuilder::FormatUint(rp, last);
+        *rp++ = '/';
+        rp += ResponseBuilder::FormatUint(rp, total);
+        *rp++ = '\r'; *rp++ = '\n'; *rp = '\0';
+        size_t headerLen = ResponseBuilder::BuildHeader(
+            header, 206, isKeepAlive_, last - start + 1, nullptr, nullptr, rangeLine);
+        writeBuff_.Append(header, headerLen);
+        fileFd_ = fileHandle_.Fd();
+        fileOff_ = static_cast<off_t>(start);
+        fileLen_ = last - start + 1;
         return;
     }
 
-    // MAP_PRIVATE 表示内存映射私有，不影响原文件
-    // PROT_READ 表示只读
-    file_ = static_cast<char*>(mmap(nullptr, fileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0));
-    close(srcFd); // 映射后就可以关闭文件描述符了
-
-    // 5. 设置 iovec 分散写数组
-    // 第一块：HTTP 响应头 (存放在写缓冲区)
-    iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
-    iov_[0].iov_len = writeBuff_.ReadAbleBytes();   
+    // 3. 内容协商：文本类资源优先给预压缩变体（压一次、发无数次，egress 省 80%）
+    if(IsCompressible_(path_)) {
+        std::shared_ptr<std::vector<char>> variant;
+        const char* encoding = nullptr;
+        if(acceptBr_) {
+            variant = FileCache::Instance()->GetVariant(fileHandle_, FileCache::BR);
+            if(variant) { encoding = "br"; }
+        }
+        if(!variant && acceptGzip_) {
+            variant = FileCache::Instance()->GetVariant(fileHandle_, FileCache::GZIP);
+            if(variant) { encoding = "gzip"; }
+        }
+        if(variant) {
+            char header[ResponseBuilder::MAX_HEADER_LEN];
+            size_t headerLen = ResponseBuilder::BuildHeader(
+                header, 200, isKeepAlive_, variant->size(), nullptr, encoding);
+            writeBuff_.Append(header, headerLen);
+            bodyData_ = std::move(variant); // 压缩字节走 writev 的第二块 iov
+            fileHandle_.Release();          // 不走 sendfile 了
+            return;
+        }
+    }
 
-    // 第二块：文件内容 (存放在 mmap 映射的内存中)
-    iov_[1].iov_base = file_;
-    iov_[1].iov_len = fileStat_.st_size;
+    // 4. 文件存在，生成 200 OK 的 HTTP 响应头（状态行/Date/Connection 都是缓存块）
+    //    带 Accept-Ranges 告诉媒体播放器这里支持拖进度条
+    char header[ResponseBuilder::MAX_HEADER_LEN];
+    size_t headerLen = ResponseBuilder::BuildHeader(
+        header, 200, isKeepAlive_, fileStat_.st_size, nullptr, nullptr,
+        "Accept-Ranges: bytes\r\n");
+    writeBuff_.Append(header, headerLen);
 
-    iovCnt_ = 2; // 需要发送两块数据
+    // 4. fd 来自缓存句柄，发送阶段交给 sendfile（零拷贝）
+    //    sendfile 用的是显式 offset，不动 fd 的文件位置，多个连接可共享同一个 fd
+    //    （iov 由 Process() 出口统一设置，响应头存放在 writeBuff_）
+    fileFd_ = fileHandle_.Fd();
+    fileOff_ = 0;
+    fileLen_ = fileStat_.st_size;
 }
 // 一些get方法
 int HttpConn::GetFd() const { return fd_; }
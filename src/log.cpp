@@ -1,59 +1,72 @@
 #include "log.h"
 #include <cstring>
+#include <cctype>
 #include <ctime>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h> // mmap 段文件
+#include <fcntl.h>
+#include <unistd.h>
 #include <stdarg.h>
-
-// ==================== BlockQueue 实现 ====================
-
-void Log::BlockQueue::Push(const std::string& item) {
-    std::unique_lock<std::mutex> lock(mtx);
-    // 队列满时阻塞生产者（背压机制）
-    condProducer.wait(lock, [this]{ return queue.size() < capacity || isClosed; });
-    if (isClosed) return;
-    queue.push(item);
-    condConsumer.notify_one();
+#include <chrono>
+
+// ==================== 二进制日志帧格式 ====================
+// 段文件头：8 字节魔数。之后是连续的帧：
+//   定义帧: [u8 type=1][u32 fmtId][u16 fmtLen][fmtLen 字节格式串]
+//   记录帧: [u8 type=2][u32 fmtId][u8 level][i64 sec][u32 usec][u16 payloadLen][参数字节]
+// 参数字节按格式串里的转换说明排列：整数/字符/指针 8 字节，浮点 8 字节，
+// 字符串为 [u16 len][len 字节]。全部原生字节序（离线工具和服务器同机读取）。
+static const char BLOG_MAGIC[8] = {'W', 'S', 'B', 'L', 'O', 'G', '0', '1'};
+static const uint8_t FRAME_FMTDEF = 1;
+static const uint8_t FRAME_RECORD = 2;
+static const size_t BLOG_MAX_STR = 256; // 单个 %s 参数最多记录的字节数
+
+// ==================== SpscRing 实现 ====================
+
+// 容量向上取整到 2 的幂，方便用位与做环绕
+Log::SpscRing::SpscRing(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) { cap <<= 1; }
+    slots.resize(cap);
+    mask = cap - 1;
 }
 
-bool Log::BlockQueue::Pop(std::string& item) {
-    std::unique_lock<std::mutex> lock(mtx);
-    condConsumer.wait(lock, [this]{ return !queue.empty() || isClosed; });
-    if (isClosed && queue.empty()) return false;
-    item = std::move(queue.front());
-    queue.pop();
-    condProducer.notify_one();
+// 只被属主线程调用：满了返回 false，由调用方决定丢弃
+bool Log::SpscRing::Push(std::string&& line) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    if (t - h > mask) {
+        return false; // 环满
+    }
+    slots[t & mask] = std::move(line);
+    tail.store(t + 1, std::memory_order_release); // 发布给消费端
     return true;
 }
 
-void Log::BlockQueue::Close() {
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        isClosed = true;
+// 只被写盘线程调用：空了返回 false
+bool Log::SpscRing::Pop(std::string& line) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    if (h == t) {
+        return false; // 环空
     }
-    condConsumer.notify_all();
-    condProducer.notify_all();
-}
-
-void Log::BlockQueue::Flush() {
-    condConsumer.notify_one();
-}
-
-bool Log::BlockQueue::Empty() {
-    std::lock_guard<std::mutex> lock(mtx);
-    return queue.empty();
+    line = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release); // 归还槽位给生产端
+    return true;
 }
 
 // ==================== Log 实现 ====================
 
 Log::Log() : path_(nullptr), suffix_(nullptr),
-             level_(INFO), today_(0), isOpen_(false), isAsync_(false) {
+             level_(INFO), today_(0), isOpen_(false), isAsync_(false),
+             ringCapacity_(8192) {
 }
 
 Log::~Log() {
-    // 关闭异步写线程
+    // 关闭异步写线程（会把所有环里剩的日志清干净）
     if (writeThread_ && writeThread_->joinable()) {
-        blockQueue_->Close();
+        stop_ = true;
+        wakeCond_.notify_all();
         writeThread_->join();
     }
     std::lock_guard<std::mutex> lock(fileMtx_);
@@ -61,6 +74,7 @@ Log::~Log() {
         fp_.flush();
         fp_.close();
     }
+    CloseSegment_(); // 二进制模式：截断到实际长度并解除映射
 }
 
 Log* Log::Instance() {
@@ -69,11 +83,14 @@ Log* Log::Instance() {
 }
 
 void Log::Init(const char* path, const char* suffix,
-               int maxQueueCapacity, Level level) {
+               int maxQueueCapacity, Level level,
+               bool binaryMode, size_t segmentBytes) {
     level_ = level;
     path_ = path;
     suffix_ = suffix;
     isOpen_ = true;
+    binary_ = binaryMode;
+    segBytes_ = segmentBytes;
 
     // 创建日志目录
     mkdir(path, 0755);
@@ -81,9 +98,8 @@ void Log::Init(const char* path, const char* suffix,
     // 设置异步模式
     if (maxQueueCapacity > 0) {
         isAsync_ = true;
-        if (!blockQueue_) {
-            blockQueue_ = std::unique_ptr<BlockQueue>(new BlockQueue());
-            blockQueue_->capacity = maxQueueCapacity;
+        ringCapacity_ = maxQueueCapacity;
+        if (!writeThread_) {
             // 启动后台写线程
             writeThread_ = std::unique_ptr<std::thread>(
                 new std::thread(&Log::AsyncWriteThread_, this));
@@ -92,8 +108,13 @@ void Log::Init(const char* path, const char* suffix,
         isAsync_ = false;
     }
 
-    // 打开当天的日志文件
-    CheckDateAndOpenFile_();
+    // 打开当天的日志文件 / 第一个二进制段
+    if (binary_) {
+        std::lock_guard<std::mutex> lock(fileMtx_);
+        OpenSegment_();
+    } else {
+        CheckDateAndOpenFile_();
+    }
 
     // 写一条启动日志
     Write(INFO, "========== Log system initialized [%s] ==========",
@@ -132,7 +153,230 @@ void Log::AppendLogLevelTitle_(Level level, char* buf, int& idx) {
     }
 }
 
+// 取当前线程的环形队列：第一次调用时创建并注册（注册锁每线程一生只拿一次）
+Log::SpscRing* Log::RingForThisThread_() {
+    thread_local std::shared_ptr<SpscRing> tRing;
+    if (!tRing) {
+        tRing = std::make_shared<SpscRing>(ringCapacity_);
+        std::lock_guard<std::mutex> lock(ringRegMtx_);
+        rings_.push_back(tRing); // 注册表持有引用：线程退出后剩余日志仍会被写盘
+    }
+    return tRing.get();
+}
+
+// ==================== 二进制模式实现 ====================
+
+// 预分配并 mmap 下一个段文件（调用方持 fileMtx_）
+bool Log::OpenSegment_() {
+    time_t now = time(nullptr);
+    struct tm t;
+    localtime_r(&now, &t);
+    char filename[LOG_NAME_LEN] = {0};
+    snprintf(filename, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d_%03d.blog",
+             path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, segSeq_++);
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { return false; }
+    // 🌟 预分配整段再 mmap：写日志就是一次 memcpy，零 write 系统调用；
+    // 页由内核回写线程按自己的节奏刷盘，热路径上连 page fault 都摊薄在整段上
+    if (ftruncate(fd, (off_t)segBytes_) < 0) { close(fd); return false; }
+    void* base = mmap(nullptr, segBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) { close(fd); return false; }
+    segFd_ = fd;
+    segBase_ = static_cast<char*>(base);
+    memcpy(segBase_, BLOG_MAGIC, sizeof(BLOG_MAGIC));
+    segOff_ = sizeof(BLOG_MAGIC);
+
+    // 【修正】段头重放全部已知格式串定义：定义帧原本每个进程只发一次，
+    // 滚动出来的段单独拿去 blogcat 就全是 <unknown format id>。在段头
+    // 补齐定义让每个段自包含。锁序是 fileMtx_ → fmtMtx_，反向不存在
+    // （WriteBinary_ 拿 fmtMtx_ 期间不碰 fileMtx_）
+    {
+        std::lock_guard<std::mutex> lock(fmtMtx_);
+        for (const auto& kv : fmtIds_) {
+            uint16_t fmtLen = (uint16_t)strlen(kv.first);
+            size_t frameLen = 7 + (size_t)fmtLen;
+            if (segOff_ + frameLen > segBytes_) { break; } // 段比定义表还小：不至于，防御一下
+            char* p = segBase_ + segOff_;
+            p[0] = (char)FRAME_FMTDEF;
+            memcpy(p + 1, &kv.second, 4);
+            memcpy(p + 5, &fmtLen, 2);
+            memcpy(p + 7, kv.first, fmtLen);
+            segOff_ += frameLen;
+        }
+    }
+    return true;
+}
+
+// msync + 截断到实际写入长度 + 解除映射（调用方持 fileMtx_）
+void Log::CloseSegment_() {
+    if (segBase_ == nullptr) { return; }
+    msync(segBase_, segOff_, MS_SYNC);
+    munmap(segBase_, segBytes_);
+    if (ftruncate(segFd_, (off_t)segOff_) < 0) { /* 截断失败只是段尾多些零字节 */ }
+    close(segFd_);
+    segBase_ = nullptr;
+    segFd_ = -1;
+    segOff_ = 0;
+}
+
+// 帧追加进当前段；放不下就切下一段（调用方持 fileMtx_）
+void Log::AppendFrame_(const char* data, size_t len) {
+    if (segBase_ == nullptr || segOff_ + len > segBytes_) {
+        CloseSegment_();
+        if (!OpenSegment_()) { return; }
+    }
+    memcpy(segBase_ + segOff_, data, len);
+    segOff_ += len;
+}
+
+// 按格式串里的转换说明把 va_list 序列化成原始字节（不做任何格式化）
+size_t Log::EncodeArgs_(const char* format, va_list args, char* out, size_t cap) {
+    size_t off = 0;
+    // 容量不够直接停止编码（剩余参数丢弃，读取端按 payload 长度自然截断）
+    auto fits = [&](size_t n) { return off + n <= cap; };
+
+    for (const char* p = format; *p; ++p) {
+        if (*p != '%') { continue; }
+        ++p;
+        if (*p == '%') { continue; } // 字面量 %%
+        // 标志位
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') { ++p; }
+        // 宽度（* 从参数来，同样序列化）
+        if (*p == '*') {
+            if (!fits(8)) { break; }
+            int64_t w = va_arg(args, int);
+            memcpy(out + off, &w, 8); off += 8;
+            ++p;
+        } else { while (isdigit((unsigned char)*p)) { ++p; } }
+        // 精度
+        if (*p == '.') {
+            ++p;
+            if (*p == '*') {
+                if (!fits(8)) { break; }
+                int64_t pr = va_arg(args, int);
+                memcpy(out + off, &pr, 8); off += 8;
+                ++p;
+            } else { while (isdigit((unsigned char)*p)) { ++p; } }
+        }
+        // 长度修饰符
+        int longs = 0; bool sized = false;
+        while (*p == 'l' || *p == 'h' || *p == 'z' || *p == 't') {
+            if (*p == 'l') { longs++; }
+            if (*p == 'z' || *p == 't') { sized = true; }
+            ++p;
+        }
+        switch (*p) {
+            case 'd': case 'i': case 'c': {
+                if (!fits(8)) { return off; }
+                int64_t v = sized   ? (int64_t)va_arg(args, long)
+                            : longs >= 2 ? (int64_t)va_arg(args, long long)
+                            : longs == 1 ? (int64_t)va_arg(args, long)
+                                         : (int64_t)va_arg(args, int);
+                memcpy(out + off, &v, 8); off += 8;
+                break;
+            }
+            case 'u': case 'o': case 'x': case 'X': {
+                if (!fits(8)) { return off; }
+                int64_t v = sized   ? (int64_t)va_arg(args, size_t)
+                            : longs >= 2 ? (int64_t)va_arg(args, unsigned long long)
+                            : longs == 1 ? (int64_t)va_arg(args, unsigned long)
+                                         : (int64_t)va_arg(args, unsigned int);
+                memcpy(out + off, &v, 8); off += 8;
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': {
+                if (!fits(8)) { return off; }
+                double v = va_arg(args, double);
+                memcpy(out + off, &v, 8); off += 8;
+                break;
+            }
+            case 's': {
+                const char* s = va_arg(args, const char*);
+                if (s == nullptr) { s = "(null)"; }
+                uint16_t len = (uint16_t)(strnlen(s, BLOG_MAX_STR));
+                if (!fits(2u + len)) { return off; }
+                memcpy(out + off, &len, 2); off += 2;
+                memcpy(out + off, s, len); off += len;
+                break;
+            }
+            case 'p': {
+                if (!fits(8)) { return off; }
+                int64_t v = (int64_t)(uintptr_t)va_arg(args, void*);
+                memcpy(out + off, &v, 8); off += 8;
+                break;
+            }
+            default: break; // 未知转换：不取参数（和 printf 的未定义行为打平）
+        }
+    }
+    return off;
+}
+
+// 业务线程侧：编帧并入队（首次见到的格式串先在同一帧块里带上定义帧，
+// 定义帧可能晚于其它线程的记录帧落盘，blogcat 两遍扫描先收定义再渲染）
+void Log::WriteBinary_(Level level, const char* format, va_list args) {
+    uint32_t id;
+    bool firstSeen = false;
+    {
+        std::lock_guard<std::mutex> lock(fmtMtx_);
+        auto it = fmtIds_.find(format);
+        if (it == fmtIds_.end()) {
+            id = nextFmtId_++;
+            fmtIds_[format] = id;
+            firstSeen = true;
+        } else {
+            id = it->second;
+        }
+    }
+
+    char payload[LOG_BUF_SIZE];
+    size_t plen = EncodeArgs_(format, args, payload, sizeof(payload));
+
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t sec = (int64_t)now.tv_sec;
+    uint32_t usec = (uint32_t)now.tv_usec;
+
+    std::string frame;
+    frame.reserve((firstSeen ? 7 + strlen(format) : 0) + 20 + plen);
+    if (firstSeen) {
+        uint16_t fmtLen = (uint16_t)strlen(format);
+        frame.push_back((char)FRAME_FMTDEF);
+        frame.append(reinterpret_cast<const char*>(&id), 4);
+        frame.append(reinterpret_cast<const char*>(&fmtLen), 2);
+        frame.append(format, fmtLen);
+    }
+    uint8_t lv = (uint8_t)level;
+    uint16_t plen16 = (uint16_t)plen;
+    frame.push_back((char)FRAME_RECORD);
+    frame.append(reinterpret_cast<const char*>(&id), 4);
+    frame.append(reinterpret_cast<const char*>(&lv), 1);
+    frame.append(reinterpret_cast<const char*>(&sec), 8);
+    frame.append(reinterpret_cast<const char*>(&usec), 4);
+    frame.append(reinterpret_cast<const char*>(&plen16), 2);
+    frame.append(payload, plen);
+
+    if (isAsync_) {
+        if (!RingForThisThread_()->Push(std::move(frame))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeCond_.notify_one();
+    } else {
+        std::lock_guard<std::mutex> lock(fileMtx_);
+        AppendFrame_(frame.data(), frame.size());
+    }
+}
+
 void Log::Write(Level level, const char* format, ...) {
+    // 🌟 二进制模式：只序列化格式串 ID + 原始参数字节，零格式化
+    if (binary_) {
+        va_list args;
+        va_start(args, format);
+        WriteBinary_(level, format, args);
+        va_end(args);
+        return;
+    }
+
     // 时间戳
     struct timeval now;
     gettimeofday(&now, nullptr);
@@ -144,7 +388,7 @@ void Log::Write(Level level, const char* format, ...) {
         CheckDateAndOpenFile_();
     }
 
-    // 格式化日志
+    // 格式化日志（在调用线程本地完成，不持有任何锁）
     char buf[LOG_BUF_SIZE] = {0};
     int idx = 0;
 
@@ -171,9 +415,13 @@ void Log::Write(Level level, const char* format, ...) {
 
     std::string logLine(buf, idx);
 
-    if (isAsync_ && blockQueue_) {
-        // 异步：入队，由后台线程写盘
-        blockQueue_->Push(logLine);
+    if (isAsync_) {
+        // 异步：无锁入本线程的环形队列，由后台线程写盘
+        // 溢出策略：丢弃并计数，绝不阻塞业务线程（背压改成可观测的丢弃）
+        if (!RingForThisThread_()->Push(std::move(logLine))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeCond_.notify_one();
     } else {
         // 同步：直接写盘
         std::lock_guard<std::mutex> lock(fileMtx_);
@@ -185,10 +433,11 @@ void Log::Write(Level level, const char* format, ...) {
 }
 
 void Log::Flush() {
-    if (isAsync_ && blockQueue_) {
-        blockQueue_->Flush();
-    }
+    wakeCond_.notify_one();
     std::lock_guard<std::mutex> lock(fileMtx_);
+    if (binary_ && segBase_ != nullptr) {
+        msync(segBase_, segOff_, MS_ASYNC); // 让内核尽快回写已写入的帧
+    }
     if (fp_.is_open()) {
         fp_.flush();
     }
@@ -202,16 +451,38 @@ void Log::SetLevel(Level level) {
     level_ = level;
 }
 
-// 后台异步写线程：不断从队列取日志写入文件
+// 后台异步写线程：轮询所有线程的环形队列，统一顺序写盘
 void Log::AsyncWriteThread_() {
     std::string logLine;
-    while (blockQueue_->Pop(logLine)) {
-        std::lock_guard<std::mutex> lock(fileMtx_);
-        if (fp_.is_open()) {
-            fp_ << logLine;
+    while (true) {
+        size_t drained = 0;
+        {
+            // 快照当前注册的环（注册很少发生，锁开销可忽略）
+            std::vector<std::shared_ptr<SpscRing>> snapshot;
+            {
+                std::lock_guard<std::mutex> lock(ringRegMtx_);
+                snapshot = rings_;
+            }
+            std::lock_guard<std::mutex> fileLock(fileMtx_);
+            for (auto& ring : snapshot) {
+                while (ring->Pop(logLine)) {
+                    if (binary_) {
+                        AppendFrame_(logLine.data(), logLine.size());
+                    } else if (fp_.is_open()) {
+                        fp_ << logLine;
+                    }
+                    drained++;
+                }
+            }
+        }
+        if (drained == 0) {
+            if (stop_) { break; } // 所有环都空了才能退出
+            // 没活干：挂起等业务线程来敲门（带超时兜底）
+            std::unique_lock<std::mutex> lock(wakeMtx_);
+            wakeCond_.wait_for(lock, std::chrono::milliseconds(2));
         }
     }
-    // 队列关闭后，刷盘
+    // 退出前刷盘
     std::lock_guard<std::mutex> lock(fileMtx_);
     if (fp_.is_open()) {
         fp_.flush();
@@ -0,0 +1,187 @@
+#include "metrics.h"
+#include <chrono>
+
+// Prometheus 指标名（下标和枚举一一对应）
+static const char *COUNTER_NAME[Metrics::COUNTER_CNT] = {
+    "webserver_connections_accepted_total",
+    "webserver_connections_closed_total",
+    "webserver_read_events_total",
+    "webserver_write_events_total",
+    "webserver_http_requests_total",
+    "webserver_threadpool_tasks_submitted_total",
+    "webserver_ai_cache_hits_total",
+    "webserver_ai_cache_misses_total",
+};
+
+static const char *HISTO_NAME[Metrics::HISTOGRAM_CNT] = {
+    "webserver_request_duration_us",
+    "webserver_task_wait_us",
+    "webserver_ai_predict_duration_us",
+    "webserver_stage_queue_us",
+    "webserver_stage_parse_us",
+    "webserver_stage_build_us",
+    "webserver_stage_write_us",
+};
+
+Metrics *Metrics::Instance()
+{
+    static Metrics metrics;
+    return &metrics;
+} // 单例模式，获取唯一实例
+
+uint64_t Metrics::NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+uint64_t Metrics::NowTsc()
+{
+    return __builtin_ia32_rdtsc();
+}
+
+// TSC 频率校准：静态初始化时用 2ms 的窗口对表一次。现代 x86 的 TSC
+// 是恒定频率且跨核同步的（constant_tsc/nonstop_tsc），对一次管全程
+static uint64_t CalibrateTscPerMs_()
+{
+    uint64_t t0 = Metrics::NowUs();
+    uint64_t c0 = Metrics::NowTsc();
+    while (Metrics::NowUs() - t0 < 2000) {} // 忙等 2ms（只在进程启动时发生一次）
+    uint64_t elapsedUs = Metrics::NowUs() - t0;
+    uint64_t cycles = Metrics::NowTsc() - c0;
+    return cycles * 1000 / elapsedUs; // 每毫秒周期数（保留精度，除微秒会丢尾数）
+}
+
+uint64_t Metrics::TscToUs(uint64_t tscDelta)
+{
+    static const uint64_t tscPerMs = CalibrateTscPerMs_();
+    return tscDelta * 1000 / tscPerMs;
+}
+
+#else // 非 x86：TSC 戳退化为微秒时钟，换算是恒等
+
+uint64_t Metrics::NowTsc() { return NowUs(); }
+uint64_t Metrics::TscToUs(uint64_t tscDelta) { return tscDelta; }
+
+#endif
+
+// 本线程的分片：首次调用时按轮转序号分配，之后固定不变
+Metrics::Shard &Metrics::LocalShard_()
+{
+    thread_local int shardId = nextShard_.fetch_add(1, std::memory_order_relaxed) & (SHARD_CNT - 1);
+    return shards_[shardId];
+}
+
+void Metrics::Inc(Counter c, uint64_t delta)
+{
+    LocalShard_().counters[c].fetch_add(delta, std::memory_order_relaxed);
+}
+
+// 对数分桶：us 落进第 floor(log2(us)) 个桶，0/1us 进第 0 桶
+void Metrics::Observe(Histogram h, uint64_t us)
+{
+    int bucket = 0;
+    uint64_t v = us;
+    while (v > 1 && bucket < BUCKET_CNT - 1)
+    {
+        v >>= 1;
+        bucket++;
+    }
+    Shard &shard = LocalShard_();
+    shard.buckets[h][bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum[h].fetch_add(us, std::memory_order_relaxed);
+    shard.count[h].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::RegisterGauge(const char *name, std::function<uint64_t()> fn)
+{
+    std::lock_guard<std::mutex> lock(gaugeMtx_);
+    gauges_.emplace_back(name, std::move(fn));
+}
+
+std::string Metrics::Render()
+{
+    std::string out;
+    out.reserve(8192);
+
+    // 1. 计数器：跨分片求和
+    for (int c = 0; c < COUNTER_CNT; c++)
+    {
+        uint64_t total = 0;
+        for (int s = 0; s < SHARD_CNT; s++)
+        {
+            total += shards_[s].counters[c].load(std::memory_order_relaxed);
+        }
+        out += "# TYPE ";
+        out += COUNTER_NAME[c];
+        out += " counter\n";
+        out += COUNTER_NAME[c];
+        out += " ";
+        out += std::to_string(total);
+        out += "\n";
+    }
+
+    // 2. 直方图：按 Prometheus 惯例输出累积桶 + _sum + _count
+    for (int h = 0; h < HISTOGRAM_CNT; h++)
+    {
+        out += "# TYPE ";
+        out += HISTO_NAME[h];
+        out += " histogram\n";
+        uint64_t cumulative = 0;
+        for (int b = 0; b < BUCKET_CNT; b++)
+        {
+            uint64_t cnt = 0;
+            for (int s = 0; s < SHARD_CNT; s++)
+            {
+                cnt += shards_[s].buckets[h][b].load(std::memory_order_relaxed);
+            }
+            cumulative += cnt;
+            out += HISTO_NAME[h];
+            if (b < BUCKET_CNT - 1)
+            {
+                out += "_bucket{le=\"";
+                out += std::to_string(1ull << b);
+                out += "\"} ";
+            }
+            else
+            {
+                out += "_bucket{le=\"+Inf\"} ";
+            }
+            out += std::to_string(cumulative);
+            out += "\n";
+        }
+        uint64_t sum = 0, count = 0;
+        for (int s = 0; s < SHARD_CNT; s++)
+        {
+            sum += shards_[s].sum[h].load(std::memory_order_relaxed);
+            count += shards_[s].count[h].load(std::memory_order_relaxed);
+        }
+        out += HISTO_NAME[h];
+        out += "_sum ";
+        out += std::to_string(sum);
+        out += "\n";
+        out += HISTO_NAME[h];
+        out += "_count ";
+        out += std::to_string(count);
+        out += "\n";
+    }
+
+    // 3. 仪表：抓取时现场求值（队列深度、空闲连接数等瞬时量）
+    {
+        std::lock_guard<std::mutex> lock(gaugeMtx_);
+        for (auto &gauge : gauges_)
+        {
+            out += "# TYPE ";
+            out += gauge.first;
+            out += " gauge\n";
+            out += gauge.first;
+            out += " ";
+            out += std::to_string(gauge.second());
+            out += "\n";
+        }
+    }
+    return out;
+}
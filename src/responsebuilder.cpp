@@ -0,0 +1,139 @@
+#include "responsebuilder.h"
+#include <cstring>
+#include <ctime>
+
+// 编译期驻留的常量字节块：常用状态行和 Connection 头
+// （用 sizeof-1 拿长度，memcpy 时连长度都是编译期常量）
+static const char STATUS_200[] = "HTTP/1.1 200 OK\r\n";
+static const char STATUS_206[] = "HTTP/1.1 206 Partial Content\r\n";
+static const char STATUS_400[] = "HTTP/1.1 400 Bad Request\r\n";
+static const char STATUS_403[] = "HTTP/1.1 403 Forbidden\r\n";
+static const char STATUS_404[] = "HTTP/1.1 404 Not Found\r\n";
+static const char STATUS_413[] = "HTTP/1.1 413 Payload Too Large\r\n";
+static const char STATUS_416[] = "HTTP/1.1 416 Range Not Satisfiable\r\n";
+static const char STATUS_431[] = "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+static const char STATUS_500[] = "HTTP/1.1 500 Internal Server Error\r\n";
+static const char STATUS_503[] = "HTTP/1.1 503 Service Unavailable\r\n";
+static const char CONN_KEEPALIVE[] = "Connection: keep-alive\r\n";
+static const char CONN_CLOSE[] = "Connection: close\r\n";
+static const char CONTENT_LENGTH[] = "Content-Length: ";
+static const char CONTENT_TYPE[] = "Content-Type: ";
+static const char CONTENT_ENCODING[] = "Content-Encoding: ";
+
+// 手写无符号十进制格式化：先写到临时数组再反转，无堆分配
+size_t ResponseBuilder::FormatUint(char *out, size_t value)
+{
+    char tmp[20];
+    size_t n = 0;
+    do
+    {
+        tmp[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+// 每秒缓存的 Date 头：线程本地存整条 "Date: Fri, 29 Aug 2026 ... GMT\r\n"，
+// 同一秒内的后续响应直接 memcpy，不再走 strftime
+size_t ResponseBuilder::AppendDate_(char *out)
+{
+    thread_local time_t cachedSec = 0;
+    thread_local char cachedLine[48];
+    thread_local size_t cachedLen = 0;
+
+    time_t now = time(nullptr);
+    if (now != cachedSec)
+    {
+        struct tm gmt;
+        gmtime_r(&now, &gmt);
+        cachedLen = strftime(cachedLine, sizeof(cachedLine),
+                             "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &gmt);
+        cachedSec = now;
+    }
+    memcpy(out, cachedLine, cachedLen);
+    return cachedLen;
+}
+
+size_t ResponseBuilder::BuildHeader(char *out, int code, bool keepAlive,
+                                    size_t contentLength, const char *contentType,
+                                    const char *contentEncoding, const char *extraHeader)
+{
+    char *p = out;
+
+    // 1. 状态行（驻留常量块）
+    switch (code)
+    {
+        case 200: memcpy(p, STATUS_200, sizeof(STATUS_200) - 1); p += sizeof(STATUS_200) - 1; break;
+        case 206: memcpy(p, STATUS_206, sizeof(STATUS_206) - 1); p += sizeof(STATUS_206) - 1; break;
+        case 400: memcpy(p, STATUS_400, sizeof(STATUS_400) - 1); p += sizeof(STATUS_400) - 1; break;
+        case 403: memcpy(p, STATUS_403, sizeof(STATUS_403) - 1); p += sizeof(STATUS_403) - 1; break;
+        case 404: memcpy(p, STATUS_404, sizeof(STATUS_404) - 1); p += sizeof(STATUS_404) - 1; break;
+        case 413: memcpy(p, STATUS_413, sizeof(STATUS_413) - 1); p += sizeof(STATUS_413) - 1; break;
+        case 416: memcpy(p, STATUS_416, sizeof(STATUS_416) - 1); p += sizeof(STATUS_416) - 1; break;
+        case 431: memcpy(p, STATUS_431, sizeof(STATUS_431) - 1); p += sizeof(STATUS_431) - 1; break;
+        case 503: memcpy(p, STATUS_503, sizeof(STATUS_503) - 1); p += sizeof(STATUS_503) - 1; break;
+        default:  memcpy(p, STATUS_500, sizeof(STATUS_500) - 1); p += sizeof(STATUS_500) - 1; break;
+    }
+
+    // 2. Date 头（每秒缓存）
+    p += AppendDate_(p);
+
+    // 3. Connection 头
+    if (keepAlive)
+    {
+        memcpy(p, CONN_KEEPALIVE, sizeof(CONN_KEEPALIVE) - 1);
+        p += sizeof(CONN_KEEPALIVE) - 1;
+    }
+    else
+    {
+        memcpy(p, CONN_CLOSE, sizeof(CONN_CLOSE) - 1);
+        p += sizeof(CONN_CLOSE) - 1;
+    }
+
+    // 4. Content-Type 头（可选）
+    if (contentType)
+    {
+        memcpy(p, CONTENT_TYPE, sizeof(CONTENT_TYPE) - 1);
+        p += sizeof(CONTENT_TYPE) - 1;
+        size_t typeLen = strlen(contentType);
+        memcpy(p, contentType, typeLen);
+        p += typeLen;
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    // 5. Content-Encoding 头（可选，预压缩变体用）
+    if (contentEncoding)
+    {
+        memcpy(p, CONTENT_ENCODING, sizeof(CONTENT_ENCODING) - 1);
+        p += sizeof(CONTENT_ENCODING) - 1;
+        size_t encLen = strlen(contentEncoding);
+        memcpy(p, contentEncoding, encLen);
+        p += encLen;
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    // 6. 额外头部（已拼好的整行，如 Content-Range / Accept-Ranges）
+    if (extraHeader)
+    {
+        size_t extraLen = strlen(extraHeader);
+        memcpy(p, extraHeader, extraLen);
+        p += extraLen;
+    }
+
+    // 7. Content-Length 头 + 空行
+    memcpy(p, CONTENT_LENGTH, sizeof(CONTENT_LENGTH) - 1);
+    p += sizeof(CONTENT_LENGTH) - 1;
+    p += FormatUint(p, contentLength);
+    *p++ = '\r';
+    *p++ = '\n';
+    *p++ = '\r';
+    *p++ = '\n';
+
+    return p - out;
+}
@@ -0,0 +1,74 @@
+#include "router.h"
+#include <cassert>
+
+Router *Router::Instance()
+{
+    static Router router;
+    return &router;
+}
+
+// FNV-1a 64 位：对小表足够均匀，且逐字节喂不需要先拼接字符串
+uint64_t Router::Hash_(const char *method, size_t methodLen,
+                       const char *path, size_t pathLen)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < methodLen; i++)
+    {
+        h = (h ^ (uint8_t)method[i]) * 1099511628211ull;
+    }
+    h = (h ^ 0) * 1099511628211ull; // 分隔字节："GET /ab" 和 "GETA /b" 不同哈希
+    for (size_t i = 0; i < pathLen; i++)
+    {
+        h = (h ^ (uint8_t)path[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+// 开放寻址插入：只在启动期单线程调用
+void Router::Register(const char *method, const char *path, Handler handler,
+                      bool dbBound)
+{
+    std::string m(method), p(path);
+    size_t idx = Hash_(m.data(), m.size(), p.data(), p.size()) & (TABLE_SIZE - 1);
+    for (size_t probe = 0; probe < TABLE_SIZE; probe++, idx = (idx + 1) & (TABLE_SIZE - 1))
+    {
+        Entry &e = table_[idx];
+        if (e.handler == nullptr)
+        {
+            e.method = std::move(m);
+            e.path = std::move(p);
+            e.handler = handler;
+            e.dbBound = dbBound;
+            return;
+        }
+        if (e.method == m && e.path == p)
+        {
+            e.handler = handler; // 重复注册：覆盖
+            e.dbBound = dbBound;
+            return;
+        }
+    }
+    assert(false && "Router table full"); // 64 个槽装不下说明该调大 TABLE_SIZE 了
+}
+
+// 查找：哈希 + 线性探测，命中空槽即确定不存在
+Router::Handler Router::Route(const std::string &method, const std::string &path,
+                              bool *dbBound) const
+{
+    size_t idx = Hash_(method.data(), method.size(), path.data(), path.size())
+                 & (TABLE_SIZE - 1);
+    for (size_t probe = 0; probe < TABLE_SIZE; probe++, idx = (idx + 1) & (TABLE_SIZE - 1))
+    {
+        const Entry &e = table_[idx];
+        if (e.handler == nullptr)
+        {
+            return nullptr;
+        }
+        if (e.method == method && e.path == path)
+        {
+            if (dbBound) { *dbBound = e.dbBound; }
+            return e.handler;
+        }
+    }
+    return nullptr;
+}
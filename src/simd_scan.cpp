@@ -0,0 +1,203 @@
+#include "simd_scan.h"
+#include <string.h>
+#include <strings.h> // strncasecmp（标量回退）
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+// ---------- 标量参考实现 ----------
+
+// memchr 找 '\r' 候选再验证下一个字节（glibc 的 memchr 本身已向量化，
+// 但每个孤立 '\r' 都要跨函数往返一次；真 SIMD 版一条掩码指令同时验证双字节）
+const char *SimdScan::FindCRLFScalar(const char *begin, const char *end)
+{
+    const char *p = static_cast<const char *>(memchr(begin, '\r', end - begin));
+    while (p && p + 1 < end)
+    {
+        if (p[1] == '\n') { return p; }
+        p = static_cast<const char *>(memchr(p + 1, '\r', end - p - 1));
+    }
+    return nullptr;
+}
+
+bool SimdScan::CaseEqScalar(const char *a, const char *b, size_t n)
+{
+    return strncasecmp(a, b, n) == 0;
+}
+
+#ifdef SIMD_SCAN_X86
+
+// ---------- SSE2 内核（x86-64 基线，所有 64 位机器都有） ----------
+
+// 双掩码匹配 "\r\n"：mr 标记 '\r' 的位置，mn 标记 '\n' 的位置，
+// mr & (mn >> 1) 的每个置位就是一个完整的 CRLF 对
+static const char *FindCRLFSse2_(const char *begin, const char *end)
+{
+    if (end - begin < 16)
+    {
+        // 超短输入：一个简单循环就够了，不值得起向量机器
+        for (const char *p = begin; p + 1 < end; p++)
+        {
+            if (p[0] == '\r' && p[1] == '\n') { return p; }
+        }
+        return nullptr;
+    }
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (begin + 16 <= end)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        unsigned mr = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr));
+        unsigned mn = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+        unsigned hits = mr & (mn >> 1);
+        if (hits) { return begin + __builtin_ctz(hits); }
+        // 跨块边界的对：本块末字节是 '\r' 且下一字节是 '\n'
+        if ((mr & 0x8000u) && begin + 16 < end && begin[16] == '\n')
+        {
+            return begin + 15;
+        }
+        begin += 16;
+    }
+    if (begin + 1 < end)
+    {
+        // 尾巴 <16 字节：倒退到 end-16 做一次重叠加载（起点之前的字节
+        // 已在上面查过不会有命中），不再逐字节兜底
+        const char *p = end - 16;
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned mr = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr));
+        unsigned mn = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+        unsigned hits = mr & (mn >> 1);
+        if (hits) { return p + __builtin_ctz(hits); }
+    }
+    return nullptr;
+}
+
+// 向量化 tolower：只对 'A'..'Z' 加 0x20（范围判断，不误伤 @ [ \ ] ^ _ 等符号）
+static inline __m128i ToLowerSse2_(__m128i v)
+{
+    __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1));
+    __m128i le = _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v);
+    __m128i isUpper = _mm_and_si128(ge, le);
+    return _mm_add_epi8(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+
+static bool CaseEqSse2_(const char *a, const char *b, size_t n)
+{
+    while (n >= 16)
+    {
+        __m128i va = ToLowerSse2_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)));
+        __m128i vb = ToLowerSse2_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) { return false; }
+        a += 16;
+        b += 16;
+        n -= 16;
+    }
+    return n == 0 || strncasecmp(a, b, n) == 0;
+}
+
+// ---------- AVX2 内核（一次 32 字节，需要运行时 CPUID 探测） ----------
+
+__attribute__((target("avx2")))
+static const char *FindCRLFAvx2_(const char *begin, const char *end)
+{
+    if (end - begin < 32)
+    {
+        return FindCRLFSse2_(begin, end); // 短输入交给 SSE2（再短走它的标量路径）
+    }
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (begin + 32 <= end)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        unsigned mr = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr));
+        unsigned mn = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf));
+        unsigned hits = mr & (mn >> 1);
+        if (hits) { return begin + __builtin_ctz(hits); }
+        if ((mr & 0x80000000u) && begin + 32 < end && begin[32] == '\n')
+        {
+            return begin + 31;
+        }
+        begin += 32;
+    }
+    if (begin + 1 < end)
+    {
+        // 尾巴 <32 字节：end-32 处一次重叠加载收尾（前面的字节已查过）
+        const char *p = end - 32;
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned mr = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr));
+        unsigned mn = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf));
+        unsigned hits = mr & (mn >> 1);
+        if (hits) { return p + __builtin_ctz(hits); }
+    }
+    return nullptr;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ToLowerAvx2_(__m256i v)
+{
+    __m256i ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1));
+    __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v);
+    __m256i isUpper = _mm256_and_si256(ge, le);
+    return _mm256_add_epi8(v, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static bool CaseEqAvx2_(const char *a, const char *b, size_t n)
+{
+    while (n >= 32)
+    {
+        __m256i va = ToLowerAvx2_(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)));
+        __m256i vb = ToLowerAvx2_(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0xFFFFFFFFu)
+        {
+            return false;
+        }
+        a += 32;
+        b += 32;
+        n -= 32;
+    }
+    return CaseEqSse2_(a, b, n);
+}
+
+// ---------- CPUID 分发：进程启动时解析一次，之后零分支 ----------
+
+static const char *(*ResolveFindCRLF_())(const char *, const char *)
+{
+    if (__builtin_cpu_supports("avx2")) { return FindCRLFAvx2_; }
+    return FindCRLFSse2_; // x86-64 基线保证 SSE2
+}
+
+static bool (*ResolveCaseEq_())(const char *, const char *, size_t)
+{
+    if (__builtin_cpu_supports("avx2")) { return CaseEqAvx2_; }
+    return CaseEqSse2_;
+}
+
+static const char *(*const g_findCrlf)(const char *, const char *) = ResolveFindCRLF_();
+static bool (*const g_caseEq)(const char *, const char *, size_t) = ResolveCaseEq_();
+
+const char *SimdScan::FindCRLF(const char *begin, const char *end)
+{
+    return g_findCrlf(begin, end);
+}
+
+bool SimdScan::CaseEq(const char *a, const char *b, size_t n)
+{
+    return g_caseEq(a, b, n);
+}
+
+#else // 非 x86：编译期直接退回标量实现
+
+const char *SimdScan::FindCRLF(const char *begin, const char *end)
+{
+    return FindCRLFScalar(begin, end);
+}
+
+bool SimdScan::CaseEq(const char *a, const char *b, size_t n)
+{
+    return CaseEqScalar(a, b, n);
+}
+
+#endif // SIMD_SCAN_X86
@@ -1,12 +1,15 @@
 #include "sqlconnpool.h"
 #include "log.h"
+#include <cstring> // strlen
 
 using namespace std;
 
 SqlConnPool::SqlConnPool()
 {
+    MAX_CONN_ = 0;
     useCount_ = 0;
     freeCount_ = 0;
+    shardCnt_ = 0;
 } // 构造函数私有化，防止外部创建
 
 SqlConnPool *SqlConnPool::Instance()
@@ -15,12 +18,21 @@ SqlConnPool *SqlConnPool::Instance()
     return &connPool;
 } // 单例模式，获取唯一实例
 
-//// 初始化：主机、端口、用户名、密码、库名、池大小
+//// 初始化：主机、端口、用户名、密码、库名、池大小、分片数
 void SqlConnPool::Init(const char *host, int port,
                        const char *user, const char *pwd,
-                       const char *dbName, int connSize)
+                       const char *dbName, int connSize, int shardCnt)
 {
     assert(connSize > 0);
+    // 分片数来自 worker 线程数；前 min(分片数, 连接数) 条连接进专属槽，
+    // 其余进溢出池
+    shardCnt_ = shardCnt > connSize ? connSize : shardCnt;
+    if (shardCnt_ > 0)
+    {
+        shards_.reset(new Shard[shardCnt_]);
+    }
+
+    int overflowCnt = 0;
     // 循环创建连接
     for (int i = 0; i < connSize; i++)
     {
@@ -37,20 +49,47 @@ void SqlConnPool::Init(const char *host, int port,
             LOG_ERROR("MySQL connect failed at connection %d", i);
             return;
         }
-        connQue_.push(sql);
+        // 先把每连接的语句缓存条目建好：之后 stmtCache_ 只读，查询不加锁
+        stmtCache_[sql];
+        if (i < shardCnt_)
+        {
+            shards_[i].slot.store(sql, std::memory_order_relaxed);
+        }
+        else
+        {
+            connQue_.push(sql);
+            overflowCnt++;
+        }
     }
     MAX_CONN_ = connSize;
     freeCount_ = connSize;
     useCount_ = 0;
     // sem_init(信号量指针, 0表示线程间共享, 初始值)
-    sem_init(&semId_, 0, MAX_CONN_); // 初始化信号量
+    sem_init(&semId_, 0, overflowCnt); // 信号量只管溢出池
+}
+
+// 本线程的分片序号：首次调用时轮转分配，之后固定
+int SqlConnPool::ShardIdx_()
+{
+    thread_local int idx = nextShard_.fetch_add(1, std::memory_order_relaxed);
+    return idx % shardCnt_;
 }
 
 // 从池中取出一个连接
 MYSQL *SqlConnPool::GetConn()
 {
+    // 快路径：本线程的专属槽（一次 exchange，无锁无争抢）
+    if (shardCnt_ > 0)
+    {
+        Shard &shard = shards_[ShardIdx_()];
+        MYSQL *sql = shard.slot.exchange(nullptr, std::memory_order_acquire);
+        if (sql)
+        {
+            return sql;
+        }
+    }
 
-    // 等待信号量 (资源 -1)，如果没有资源则阻塞
+    // 慢路径：溢出池。等待信号量 (资源 -1)，如果没有资源则阻塞
     sem_wait(&semId_);
     MYSQL *sql = nullptr;
     // 加锁保护队列
@@ -68,7 +107,17 @@ MYSQL *SqlConnPool::GetConn()
 void SqlConnPool::FreeConn(MYSQL *sql)
 {
     assert(sql);
-    { // 加锁保护队列
+    // 优先放回本线程的槽位（槽空着就成功，连接回到取它的地方）
+    if (shardCnt_ > 0)
+    {
+        Shard &shard = shards_[ShardIdx_()];
+        MYSQL *expected = nullptr;
+        if (shard.slot.compare_exchange_strong(expected, sql, std::memory_order_release))
+        {
+            return;
+        }
+    }
+    { // 槽位被占（这条连接来自溢出池）：还回溢出池
         lock_guard<mutex> locker(mtx_);
         connQue_.push(sql);
         ++freeCount_;
@@ -78,16 +127,72 @@ void SqlConnPool::FreeConn(MYSQL *sql)
     sem_post(&semId_);
 }
 
-// 获取当前空闲的连接数
+// 获取当前空闲的连接数（溢出池 + 各槽位里闲置的）
 int SqlConnPool::GetFreeConnCount()
 {
+    int cnt = 0;
+    for (int i = 0; i < shardCnt_; i++)
+    {
+        if (shards_[i].slot.load(std::memory_order_relaxed) != nullptr)
+        {
+            cnt++;
+        }
+    }
     lock_guard<mutex> locker(mtx_);
-    return connQue_.size();
+    return cnt + connQue_.size();
+}
+
+// 取该连接上缓存的预编译语句：同一个查询形状只 prepare 一次
+MYSQL_STMT *SqlConnPool::PreparedStmt(MYSQL *sql, const char *query)
+{
+    auto connIt = stmtCache_.find(sql);
+    if (connIt == stmtCache_.end())
+    {
+        return nullptr; // 不是本池的连接
+    }
+    auto &cache = connIt->second;
+    auto it = cache.find(query);
+    if (it != cache.end())
+    {
+        return it->second; // 命中：跳过 parse/plan
+    }
+    // 首次使用这个查询形状：prepare 后缓存
+    MYSQL_STMT *stmt = mysql_stmt_init(sql);
+    if (!stmt)
+    {
+        return nullptr;
+    }
+    if (mysql_stmt_prepare(stmt, query, strlen(query)) != 0)
+    {
+        LOG_ERROR("[DB] stmt prepare failed: %s", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    cache[query] = stmt;
+    return stmt;
 }
 
 // 销毁所有连接
 void SqlConnPool::DestroyPool()
 {
+    // 先关掉所有缓存的预编译语句
+    for (auto &connEntry : stmtCache_)
+    {
+        for (auto &stmtEntry : connEntry.second)
+        {
+            mysql_stmt_close(stmtEntry.second);
+        }
+    }
+    stmtCache_.clear();
+    // 收回分片槽里的连接
+    for (int i = 0; i < shardCnt_; i++)
+    {
+        MYSQL *sql = shards_[i].slot.exchange(nullptr, std::memory_order_acquire);
+        if (sql)
+        {
+            mysql_close(sql);
+        }
+    }
     lock_guard<mutex> locker(mtx_);
     while (!connQue_.empty())
     {
@@ -0,0 +1,163 @@
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel()
+    : slots_(WHEEL_SIZE, nullptr), cursor_(0), lastTick_(Clock::now())
+{
+    ref_.reserve(64);
+}
+
+// 按超时挂进对应槽位（调用方持锁）
+void TimerWheel::Link_(Node* node, int timeoutMS)
+{
+    // 至少 1 格，不然挂进当前槽会立刻过期
+    size_t ticks = (timeoutMS + SLOT_MS - 1) / SLOT_MS;
+    if (ticks == 0) { ticks = 1; }
+    node->rounds = static_cast<int>(ticks / WHEEL_SIZE);
+    node->slot = (cursor_ + ticks) % WHEEL_SIZE;
+
+    // 头插进槽位链表
+    node->prev = nullptr;
+    node->next = slots_[node->slot];
+    if (slots_[node->slot]) { slots_[node->slot]->prev = node; }
+    slots_[node->slot] = node;
+}
+
+// 从槽位链表上摘下（调用方持锁）
+void TimerWheel::Unlink_(Node* node)
+{
+    if (node->prev) { node->prev->next = node->next; }
+    else { slots_[node->slot] = node->next; }
+    if (node->next) { node->next->prev = node->prev; }
+    node->prev = node->next = nullptr;
+}
+
+// 新增定时器：如果 fd 已经存在就重挂，不存在就建新节点 —— 都是 O(1)
+void TimerWheel::add(int id, int timeout, TimeoutCallBack&& cb)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (id < 0) return;
+    auto it = ref_.find(id);
+    if (it != ref_.end())
+    {
+        Node* node = it->second;
+        node->cb = std::move(cb);
+        Unlink_(node);
+        Link_(node, timeout);
+        return;
+    }
+    Node* node = new Node();
+    node->id = id;
+    node->cb = std::move(cb);
+    Link_(node, timeout);
+    ref_[id] = node;
+}
+
+// 客户端活跃，延长超时时间：摘下重挂，O(1) 的两次链表操作
+void TimerWheel::adjust(int id, int timeout)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = ref_.find(id);
+    if (it == ref_.end()) return;
+    Node* node = it->second;
+    Unlink_(node);
+    Link_(node, timeout);
+}
+
+// 主动触发某个定时器
+void TimerWheel::doWork(int id)
+{
+    TimeoutCallBack cb;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ref_.find(id);
+        if (it == ref_.end()) return;
+        Node* node = it->second;
+        cb = std::move(node->cb);
+        Unlink_(node);
+        ref_.erase(it);
+        delete node;
+    }
+    cb(); // 锁外执行回调，避免回调里再进定时器导致死锁
+}
+
+// 只删除定时器，不执行回调
+void TimerWheel::cancel(int id)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = ref_.find(id);
+    if (it == ref_.end()) return;
+    Node* node = it->second;
+    Unlink_(node);
+    ref_.erase(it);
+    delete node;
+}
+
+void TimerWheel::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& kv : ref_)
+    {
+        delete kv.second;
+    }
+    ref_.clear();
+    for (auto& head : slots_)
+    {
+        head = nullptr;
+    }
+}
+
+// 推进轮子：每过一个槽位粒度走一格，把到期槽位里 rounds 归零的节点全部触发
+void TimerWheel::tick()
+{
+    std::vector<TimeoutCallBack> expired; // 锁外执行的回调
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        TimeStamp now = Clock::now();
+        size_t elapsed = std::chrono::duration_cast<MS>(now - lastTick_).count();
+        size_t steps = elapsed / SLOT_MS;
+        if (steps == 0) { return; }
+        if (steps > WHEEL_SIZE) { steps = WHEEL_SIZE; } // 一圈以上只需扫一圈
+        lastTick_ += MS(steps * SLOT_MS);
+
+        for (size_t s = 0; s < steps; s++)
+        {
+            cursor_ = (cursor_ + 1) % WHEEL_SIZE;
+            Node* node = slots_[cursor_];
+            while (node)
+            {
+                Node* next = node->next;
+                if (node->rounds > 0)
+                {
+                    node->rounds--; // 还没转够圈数，再等一轮
+                }
+                else
+                {
+                    expired.push_back(std::move(node->cb));
+                    Unlink_(node);
+                    ref_.erase(node->id);
+                    delete node;
+                }
+                node = next;
+            }
+        }
+    }
+    for (auto& cb : expired)
+    {
+        cb();
+    }
+}
+
+// 给 Epoll_wait 用的：看看还需要等多久才有连接超时
+// 时间轮粒度是 1 格，最多睡到下一个格子边界
+int TimerWheel::GetNextTick()
+{
+    tick();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (ref_.empty())
+    {
+        return -1; // 没有定时器，随便睡
+    }
+    size_t sinceTick = std::chrono::duration_cast<MS>(Clock::now() - lastTick_).count();
+    if (sinceTick >= SLOT_MS) { return 0; }
+    return static_cast<int>(SLOT_MS - sinceTick);
+}
@@ -0,0 +1,149 @@
+#ifdef ENABLE_IO_URING
+
+#include "uring_poller.h"
+#include <assert.h>
+#include <errno.h>
+
+// 撤销/更新类 SQE 的 user_data 标记：它们的成功完成不需要上报给事件循环
+static constexpr uint64_t CANCEL_TAG = ~0ull;
+
+UringPoller::UringPoller(int maxEvent) : ready_(maxEvent), readyCnt_(0)
+{
+    assert(maxEvent > 0);
+    // SQ 深度给到 2 倍事件数：一轮里可能同时攒下重挂和撤销两类 SQE
+    int ret = io_uring_queue_init(maxEvent * 2, &ring_, 0);
+    assert(ret == 0);
+    (void)ret;
+}
+
+UringPoller::~UringPoller()
+{
+    io_uring_queue_exit(&ring_);
+}
+
+// 取 SQE：环满时先把积压的提交掉腾出位置
+struct io_uring_sqe *UringPoller::GetSqe_()
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+    if (!sqe)
+    {
+        io_uring_submit(&ring_);
+        sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+}
+
+bool UringPoller::AddFd(int fd, uint32_t events)
+{
+    if (fd < 0) return false;
+    struct io_uring_sqe *sqe = GetSqe_();
+    if (!sqe) return false;
+    // poll 掩码里不存在 ET/ONESHOT 位：一次性 poll 本身就是 oneshot 语义
+    io_uring_prep_poll_add(sqe, fd, events & ~(EPOLLET | EPOLLONESHOT));
+    io_uring_sqe_set_data64(sqe, static_cast<uint64_t>(fd));
+    // 不带 ONESHOT 的注册在 epoll 语义下是持久的，记账以便触发后自动补挂
+    if (events & EPOLLONESHOT) { persistent_.erase(fd); }
+    else { persistent_[fd] = events; }
+    // 不立即 submit：攒到 Wait 里和等待合并成一次 io_uring_enter
+    return true;
+}
+
+bool UringPoller::ModFd(int fd, uint32_t events)
+{
+    // 上层遵循 ONESHOT 纪律：Mod 只发生在上一个 poll 已触发之后，
+    // 先撤销（防御残留的 armed poll），再重新挂上
+    if (fd < 0) return false;
+    struct io_uring_sqe *sqe = GetSqe_();
+    if (!sqe) return false;
+    io_uring_prep_poll_remove(sqe, static_cast<uint64_t>(fd));
+    io_uring_sqe_set_data64(sqe, CANCEL_TAG);
+    return AddFd(fd, events);
+}
+
+bool UringPoller::DelFd(int fd)
+{
+    if (fd < 0) return false;
+    struct io_uring_sqe *sqe = GetSqe_();
+    if (!sqe) return false;
+    io_uring_prep_poll_remove(sqe, static_cast<uint64_t>(fd));
+    io_uring_sqe_set_data64(sqe, CANCEL_TAG);
+    persistent_.erase(fd); // 摘除后不再补挂（排水时摘监听 socket 走这里）
+    io_uring_submit(&ring_);
+    return true;
+}
+
+int UringPoller::Wait(int timeoutMs)
+{
+    readyCnt_ = 0;
+    struct io_uring_cqe *cqe = nullptr;
+    int ret;
+    if (timeoutMs >= 0)
+    {
+        struct __kernel_timespec ts;
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        // 提交 + 等待合并成一次系统调用
+        ret = io_uring_submit_and_wait_timeout(&ring_, &cqe, 1, &ts, nullptr);
+    }
+    else
+    {
+        io_uring_submit(&ring_);
+        ret = io_uring_wait_cqe(&ring_, &cqe);
+    }
+    if (ret < 0 && ret != -ETIME)
+    {
+        return 0; // 超时或被信号打断，按无事件处理
+    }
+
+    // 批量收割 CQ 环里已就绪的完成事件，最多收 ready_ 的容量
+    unsigned head;
+    unsigned seen = 0;
+    io_uring_for_each_cqe(&ring_, head, cqe)
+    {
+        uint64_t data = io_uring_cqe_get_data64(cqe);
+        // 撤销类完成和失败的 poll（-ECANCELED/-ENOENT）不上报
+        if (data == CANCEL_TAG || cqe->res < 0)
+        {
+            seen++;
+            continue;
+        }
+        // 【修正】ready_ 满了就停：只推进已消费的 CQE，多出来的留在
+        // CQ 环里等下轮 Wait。一次性 poll 的完成就是事件本身，照旧
+        // advance 过去等于把这些连接的唤醒永久吞掉（epoll 没这个问题，
+        // 溢出的就绪 fd 会留到下一次 epoll_wait）
+        if (readyCnt_ == ready_.size())
+        {
+            break;
+        }
+        seen++;
+        int fd = static_cast<int>(data);
+        ready_[readyCnt_].fd = fd;
+        ready_[readyCnt_].events = static_cast<uint32_t>(cqe->res);
+        readyCnt_++;
+        // 持久注册（监听 socket、eventfd）被一次性 poll 消费掉了，
+        // 立刻补挂下一个——SQE 攒着随下轮 enter 提交。补挂早于上层
+        // 处理事件，可能多醒一次，但两类 fd 的处理都循环到 EAGAIN，
+        // 虚醒无害；晚挂才是事故（accept/唤醒从此失灵）
+        auto it = persistent_.find(fd);
+        if (it != persistent_.end())
+        {
+            AddFd(fd, it->second);
+        }
+    }
+    io_uring_cq_advance(&ring_, seen);
+    return static_cast<int>(readyCnt_);
+}
+
+int UringPoller::GetEventFd(size_t i) const
+{
+    assert(i < readyCnt_);
+    return ready_[i].fd;
+}
+
+uint32_t UringPoller::GetEvents(size_t i) const
+{
+    assert(i < readyCnt_);
+    return ready_[i].events;
+}
+
+#endif // ENABLE_IO_URING
@@ -1,95 +1,410 @@
 #include "webserver.h"
 #include "log.h"
+#include "metrics.h"
+#include "bufferpool.h"
+#include "ai_engine.h"
+#include "fdpass.h"
 #include <iostream>
+#include <dirent.h>      // opendir / readdir（文件缓存预灌）
+#include <sys/eventfd.h>
+#include <netinet/tcp.h> // TCP_NODELAY / TCP_DEFER_ACCEPT
 using namespace std;
 
+// 热升级交接点：老进程 drain 时在这里摆摊，新进程启动时来取监听 fd
+static const char *HANDOVER_SOCK = "./webserver_handover.sock";
+
 // 构造函数：装配所有零件
 WebServer::WebServer(int port, const char *srcDir,
                      const char *sqlUser, const char *sqlPwd, const char *dbName,
-                     int connPoolNum, int threadNum)
+                     int connPoolNum, int threadNum, int reactorNum,
+                     SockPolicy sockPolicy, CpuPlacement placement, WarmStart warm)
     : port_(port), isClose_(false), srcDir_(const_cast<char *>(srcDir)),
-      epoller_(new Epoller()), threadpool_(new ThreadPool(threadNum)),
-      timeoutMS_(60000), timer_(new HeapTimer())
+      reactorNum_(reactorNum > 0 ? reactorNum : 1),
+      threadpool_(new ThreadPool(threadNum, placement.workerCpus)),
+      // DB 线程池刻意小：上限就是数据库池的并发度，再多的线程也只是排队
+      dbPool_(new ThreadPool(connPoolNum < 4 ? (connPoolNum > 0 ? connPoolNum : 1) : 4)),
+      timeoutMS_(60000), sockPolicy_(sockPolicy), placement_(std::move(placement))
 {
-    // 1. 初始化数据库连接池
-    SqlConnPool::Instance()->Init("localhost", 3306, sqlUser, sqlPwd, dbName, connPoolNum);
+    // 1. 初始化数据库连接池（分片数 = worker 线程数，常态取还连接无争抢）
+    SqlConnPool::Instance()->Init("localhost", 3306, sqlUser, sqlPwd, dbName, connPoolNum, threadNum);
 
-    // 2. 初始化 HttpConn 的全局静态变量
+    // 2. 初始化 HttpConn 的全局静态变量，并注册 API 路由表
     HttpConn::srcDir_ = srcDir_;
     HttpConn::userCount_ = 0;
+    HttpConn::RegisterRoutes();
 
     // 3. 设置 Epoll 的事件模式 (监听用 LT，连接用 ET)
     InitEventMode_();
 
-    // 4. 初始化监听 Socket
-    if (!InitSocket_())
+    // 🌟 warm-start：监听 socket 上线之前先把冷的东西全摸热。
+    // 部署/故障切换后的首波流量不再踩缓冲池 malloc、文件缺页和
+    // ONNX 的懒初始化——这些成本全部在这里一次性付掉
+    WarmUp_(warm);
+
+    // 🌟 热升级接棒：如果有老进程正在 drain，先把它的监听 fd 接过来。
+    // SCM_RIGHTS 复制的是内核文件描述，新老进程共享同一个 accept 队列，
+    // 交接瞬间队列里排着的连接一个不丢
+    if (FdPass::Recv(HANDOVER_SOCK, inheritedFds_))
+    {
+        if ((int)inheritedFds_.size() == reactorNum_)
+        {
+            LOG_INFO("Inherited %zu listen fds from draining predecessor", inheritedFds_.size());
+        }
+        else
+        {
+            // 分片数变了没法一一对应，放弃继承走冷启动（老进程的 fd 关掉即可）
+            LOG_WARN("Inherited %zu listen fds but have %d shards, falling back to fresh sockets",
+                     inheritedFds_.size(), reactorNum_);
+            for (int fd : inheritedFds_) { close(fd); }
+            inheritedFds_.clear();
+        }
+    }
+
+    // 4. 为每个 Reactor 分片创建独立的 Epoller / 定时器 / 监听 socket
+    //    SO_REUSEPORT 让内核把新连接哈希分流到各分片，分片之间互不加锁
+    for (int i = 0; i < reactorNum_; i++)
     {
-        isClose_ = true;
+        reactors_.emplace_back(new Reactor());
+        Reactor &reactor = *reactors_.back();
+        reactor.id = i;
+        reactor.epoller.reset(new Poller());
+        reactor.timer.reset(new TimerWheel());
+        // 🌟 eventfd 唤醒通道：worker 线程投递延迟 epoll 操作后敲一下，
+        //    阻塞在 epoll_wait 里的 reactor 立刻醒来处理
+        reactor.wakeFd = eventfd(0, EFD_NONBLOCK);
+        if (reactor.wakeFd < 0 || !reactor.epoller->AddFd(reactor.wakeFd, EPOLLIN | EPOLLET))
+        {
+            LOG_ERROR("Create eventfd error! reactor:%d", i);
+            isClose_ = true;
+        }
+        // 【新增】slab 连接表预建：槽位和 HttpConn 对象提前 new 好，
+        // 首波连接风暴全走"原地复用"路径，零分配零 resize
+        if (warm.connSlots > 0)
+        {
+            reactor.users.resize(warm.connSlots);
+            reactor.gens.resize(warm.connSlots, 0);
+            for (int s = 0; s < warm.connSlots; s++)
+            {
+                reactor.users[s].reset(new HttpConn());
+            }
+        }
+        if (!InitSocket_(reactor))
+        {
+            isClose_ = true;
+        }
     }
+
+    // warm-start 全部完成（包括监听 socket 就位）：放行 /healthz，
+    // LB 从这一刻起才把流量切过来
+    HttpConn::serverWarm_.store(true, std::memory_order_release);
+
+    // 5. 注册抓取时求值的监控仪表（/metrics 输出瞬时量）
+    Metrics::Instance()->RegisterGauge("webserver_threadpool_queue_depth",
+                                       [this]() { return (uint64_t)threadpool_->QueueSize(); });
+    Metrics::Instance()->RegisterGauge("webserver_sql_free_connections",
+                                       []() { return (uint64_t)SqlConnPool::Instance()->GetFreeConnCount(); });
+    Metrics::Instance()->RegisterGauge("webserver_active_connections",
+                                       []() { return (uint64_t)HttpConn::userCount_.load(); });
+    Metrics::Instance()->RegisterGauge("webserver_log_dropped_lines",
+                                       []() { return Log::Instance()->DroppedCount(); });
 }
 
 WebServer::~WebServer()
 {
-    close(listenFd_);
+    for (auto &reactor : reactors_)
+    {
+        if (reactor->listenFd >= 0)
+        {
+            close(reactor->listenFd);
+        }
+        if (reactor->wakeFd >= 0)
+        {
+            close(reactor->wakeFd);
+        }
+    }
     isClose_ = true;
     SqlConnPool::Instance()->DestroyPool(); // 关闭数据库池
 }
+
 void WebServer::Start()
 {
-    int timeMS = -1; // 默认无超时
     if (!isClose_)
     {
-        LOG_INFO("========== Server start at port %d ==========", port_);
+        LOG_INFO("========== Server start at port %d (%d reactor shards) ==========",
+                 port_, reactorNum_);
     }
-    while (!isClose_ && !g_shutdown)
+    // 分片 1..N-1 各跑一个独立线程，分片 0 占用当前线程
+    std::vector<std::thread> loops;
+    for (int i = 1; i < reactorNum_; i++)
     {
-        // 从定时器中获取下一个超时的时间
-        if(timeoutMS_ > 0) {
-            timeMS = timer_->GetNextTick();
+        loops.emplace_back([this, i]() { EventLoop_(*reactors_[i]); });
+    }
+    EventLoop_(*reactors_[0]);
+    // 主分片退出 (g_shutdown)，等其余分片跟着退出
+    for (auto &t : loops)
+    {
+        t.join();
+    }
+}
+
+// 单个分片的事件循环：只碰自己的 epoller / users / timer，热路径上无跨分片共享
+void WebServer::EventLoop_(Reactor &reactor)
+{
+    // 【新增】按布局把本分片的事件循环钉到指定核上（和同节点的 worker 配对，
+    // reactor 填的 Buffer 被 worker 解析时不再跨 NUMA 节点弹缓存行）
+    if (!placement_.reactorCpus.empty())
+    {
+        int cpu = placement_.reactorCpus[reactor.id % placement_.reactorCpus.size()];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    int timeMS = -1; // 默认无超时
+    while (!isClose_)
+    {
+        // 🌟 优雅排水：收到 SIGTERM 不再立刻掐断循环。摘掉监听 socket、
+        // 健康检查翻 503，在途连接继续送完；全送完或过了排水期限才退出
+        if (g_shutdown)
+        {
+            if (!reactor.draining) { StartDrain_(reactor); }
+            if (CountLive_(reactor) == 0)
+            {
+                LOG_INFO("Reactor %d drained clean, exiting", reactor.id);
+                break;
+            }
+            if (Metrics::NowUs() >= reactor.drainDeadlineUs)
+            {
+                LOG_WARN("Reactor %d drain deadline hit, force-closing %d connections",
+                         reactor.id, CountLive_(reactor));
+                ForceCloseAll_(reactor);
+                break;
+            }
+        }
+        // 🌟 循环顶部先把 worker 攒下的延迟 epoll 操作串行执行掉：
+        //    epoll_ctl 全部收敛到 reactor 线程，不再和 epoll_wait 抢内核锁
+        DrainOps_(reactor);
+
+        // 【新增】空闲内存回收：每隔一个扫描周期把空闲 >5s 的连接的
+        // 缓冲块还给 BufferPool（连接保持打开）。大 POST 突发过后
+        // RSS 在几秒内回落，而不是钉在峰值上等 60s 超时
+        static const uint64_t SWEEP_INTERVAL_US = 5 * 1000000ull;
+        static const uint64_t IDLE_SHRINK_US = 5 * 1000000ull;
+        uint64_t nowUs = Metrics::NowUs();
+        if (nowUs - reactor.lastSweepUs >= SWEEP_INTERVAL_US)
+        {
+            reactor.lastSweepUs = nowUs;
+            for (auto &user : reactor.users)
+            {
+                if (user) { user->ShrinkIfIdle(nowUs, IDLE_SHRINK_US); }
+            }
+        }
+        // 从本分片的定时器中获取下一个超时的时间
+        if (timeoutMS_ > 0)
+        {
+            timeMS = reactor.timer->GetNextTick();
+        }
+        // 排水期间把等待上限压到排水期限内，保证期限一到立刻醒来收尾
+        if (reactor.draining)
+        {
+            int remainMS = (int)((reactor.drainDeadlineUs - Metrics::NowUs()) / 1000) + 1;
+            if (timeMS < 0 || timeMS > remainMS) { timeMS = remainMS; }
         }
         // 等待事件发生
-        int eventCnt = epoller_->Wait(timeMS);
+        int eventCnt = reactor.epoller->Wait(timeMS);
         for (int i = 0; i < eventCnt; i++)
         {
             // 获取发生事件的 fd 和事件类型
-            int fd = epoller_->GetEventFd(i);
-            uint32_t events = epoller_->GetEvents(i);
+            int fd = reactor.epoller->GetEventFd(i);
+            uint32_t events = reactor.epoller->GetEvents(i);
 
-            if (fd == listenFd_)
+            if (fd == reactor.wakeFd)
+            {
+                // worker 敲门：把计数读掉（ET 模式必须清空），操作本身在下轮循环顶部统一执行
+                uint64_t cnt;
+                while (read(reactor.wakeFd, &cnt, sizeof(cnt)) > 0) {}
+            }
+            else if (fd == reactor.listenFd)
             {
                 // 如果是监听 fd 发生事件，说明有新用户连上来了！
-                DealListen_();
+                DealListen_(reactor);
             }
             else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
             {
                 // 发生错误或者客户端断开
-                if(users_.count(fd) == 0) continue;
-                CloseConn_(&users_[fd]);
+                HttpConn *client = GetConn_(reactor, fd);
+                if (client) { CloseConn_(reactor, client); }
             }
             else if (events & EPOLLIN)
             {
                 // 有数据发过来了 (浏览器发了 HTTP 请求)
-                if(users_.count(fd) == 0) continue;
-                DealRead_(&users_[fd]);
+                HttpConn *client = GetConn_(reactor, fd);
+                if (client) { DealRead_(reactor, client); }
             }
             else if (events & EPOLLOUT)
             {
                 // 缓冲区空了，可以继续发数据了 (响应头/网页还没发完)
-                if(users_.count(fd) == 0) continue;
-                DealWrite_(&users_[fd]);
+                HttpConn *client = GetConn_(reactor, fd);
+                if (client) { DealWrite_(reactor, client); }
             }
         }
+        // 🌟 批量提交：本轮 Wait 醒来攒下的所有任务一次性交给线程池，
+        //    N 个就绪 fd 只做一轮唤醒，而不是 N 次 notify_one
+        threadpool_->AddTasks(reactor.pending);
     }
 }
+
+// --- 优雅排水与热升级 ---
+
+// 本分片进入排水模式：摘掉监听 socket（不再 accept），健康检查翻 503
+// 让 LB 把流量切走，并触发一次（全局）监听 fd 交接
+void WebServer::StartDrain_(Reactor &reactor)
+{
+    reactor.draining = true;
+    reactor.drainDeadlineUs = Metrics::NowUs() + (uint64_t)drainTimeoutMS_ * 1000;
+    reactor.epoller->DelFd(reactor.listenFd);
+    // /healthz 从这一刻起返回 503（store 幂等，几个分片都做一遍无妨）
+    HttpConn::serverWarm_.store(false, std::memory_order_release);
+    StartHandoverOnce_();
+    LOG_INFO("Reactor %d draining: stopped accepting, %d connections in flight, deadline %dms",
+             reactor.id, CountLive_(reactor), drainTimeoutMS_);
+}
+
+// 全局只做一次：起一条后台线程在交接点摆摊，把所有分片的监听 fd
+// 递给来取货的新进程。排水期限内没有新进程上门就算了（纯缩容下线）
+void WebServer::StartHandoverOnce_()
+{
+    bool expected = false;
+    if (!handoverStarted_.compare_exchange_strong(expected, true)) { return; }
+
+    std::vector<int> fds;
+    for (auto &r : reactors_)
+    {
+        if (r->listenFd >= 0) { fds.push_back(r->listenFd); }
+    }
+    int timeoutMS = drainTimeoutMS_;
+    std::thread([fds, timeoutMS]()
+                {
+                    if (FdPass::Send(HANDOVER_SOCK, fds, timeoutMS))
+                    {
+                        LOG_INFO("Handed over %zu listen fds to successor process", fds.size());
+                    }
+                    else
+                    {
+                        LOG_INFO("No successor showed up for listen fd handover (plain shutdown)");
+                    }
+                })
+        .detach();
+}
+
+// 数本分片还有几条活连接（只在排水期间调用，线性扫 slab 无所谓）
+int WebServer::CountLive_(Reactor &reactor)
+{
+    int live = 0;
+    for (auto &user : reactor.users)
+    {
+        if (user && user->GetFd() >= 0) { live++; }
+    }
+    return live;
+}
+
+// 排水超时：期限已尽，剩余连接统一强关（比无限等一个挂死的客户端强）
+void WebServer::ForceCloseAll_(Reactor &reactor)
+{
+    for (auto &user : reactor.users)
+    {
+        if (user && user->GetFd() >= 0) { CloseConn_(reactor, user.get()); }
+    }
+}
+
+// --- 启动期预热 ---
+// warm-start 阶段：缓冲池预分配并触页、静态文件预灌文件缓存、AI 引擎空推理。
+// slab 连接表的预建在分片创建处做（槽位属于各分片）
+void WebServer::WarmUp_(const WarmStart &warm)
+{
+    uint64_t t0 = Metrics::NowUs();
+
+    // 1. 缓冲池预热：各大小级填到配置块数并 memset 触页，
+    //    首波请求的借块是纯链表 pop，不踩 malloc 和缺页
+    if (warm.poolChunksPerClass > 0)
+    {
+        BufferPool::Instance()->Prewarm(warm.poolChunksPerClass);
+    }
+
+    // 2. 文件缓存预灌：递归走一遍网站根目录，在字节预算内把文件
+    //    open + stat 进缓存并预读进页缓存，热点页面首次访问即命中
+    if (warm.preloadMaxBytes > 0 && srcDir_)
+    {
+        size_t budget = warm.preloadMaxBytes;
+        PreloadDir_(srcDir_, budget);
+    }
+
+    // 3. AI 引擎预热：跑 K 次空推理，把 ONNX 首次 Run 的懒初始化
+    //    （内存 arena、算子 kernel 选择）提前付掉。每次换个输入，
+    //    免得 1e-3 量化的预测缓存把后几次短路掉
+    if (warm.aiWarmupRuns > 0 && AIEngine::Instance()->IsLoaded())
+    {
+        for (int i = 0; i < warm.aiWarmupRuns; i++)
+        {
+            std::vector<float> dummy = {(float)(i + 1) * 0.123f};
+            AIEngine::Instance()->Predict(dummy);
+        }
+    }
+
+    LOG_INFO("Warm-start done in %llu us (pool:%zu/class, preload budget:%zu, ai runs:%d)",
+             (unsigned long long)(Metrics::NowUs() - t0), warm.poolChunksPerClass,
+             warm.preloadMaxBytes, warm.aiWarmupRuns);
+}
+
+// 递归预灌文件缓存：每个常规文件拿一次 FileCache 句柄（open + stat 进缓存），
+// 再 readahead 把内容拉进页缓存。budget 用完立即停——别把内存吃爆在预热上
+void WebServer::PreloadDir_(const std::string &dir, size_t &budget)
+{
+    DIR *dp = opendir(dir.c_str());
+    if (!dp) { return; }
+    struct dirent *ent;
+    while (budget > 0 && (ent = readdir(dp)) != nullptr)
+    {
+        if (ent->d_name[0] == '.') { continue; } // 跳过 . / .. / 隐藏文件
+        std::string full = dir + "/" + ent->d_name;
+        struct stat st;
+        if (stat(full.c_str(), &st) != 0) { continue; }
+        if (S_ISDIR(st.st_mode))
+        {
+            PreloadDir_(full, budget);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || (size_t)st.st_size > budget) { continue; }
+        // Get 的 key 和请求路径拼出来的完全一致（srcDir_ + "/xx"），正式流量直接命中
+        FileCache::Handle handle = FileCache::Instance()->Get(full);
+        if (!handle.Valid()) { continue; }
+        // 预读进页缓存：之后的 sendfile 不再逐页缺页
+        if (readahead(handle.Fd(), 0, st.st_size) < 0) { /* 预读失败无伤大雅 */ }
+        budget -= (size_t)st.st_size;
+    }
+    closedir(dp);
+}
+
 // --- 核心网络初始化 ---
-bool WebServer::InitSocket_()
+bool WebServer::InitSocket_(Reactor &reactor)
 {
     if (port_ > 65535 || port_ < 1024)
         return false;
 
-    // 1. 创建监听 Socket
-    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (listenFd_ < 0)
+    // 【新增】热升级接棒：老进程递过来的监听 socket 已带完整的
+    // bind/listen 状态（以及 accept 队列里排着的连接），挂上 epoll 就能用
+    if (reactor.id < (int)inheritedFds_.size())
+    {
+        reactor.listenFd = inheritedFds_[reactor.id];
+        fcntl(reactor.listenFd, F_SETFL, fcntl(reactor.listenFd, F_GETFL, 0) | O_NONBLOCK);
+        reactor.epoller->AddFd(reactor.listenFd, listenEvent_ | EPOLLIN);
+        return true;
+    }
+
+    // 1. 创建本分片的监听 Socket
+    reactor.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (reactor.listenFd < 0)
     {
         LOG_ERROR("Create socket error! port:%d", port_);
         return false;
@@ -97,30 +412,41 @@ bool WebServer::InitSocket_()
 
     // 2. 设置 Socket 选项：端口复用
     int optval = 1;
-    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, (const void *)&optval, sizeof(int));
+    setsockopt(reactor.listenFd, SOL_SOCKET, SO_REUSEADDR, (const void *)&optval, sizeof(int));
+    // 🌟 SO_REUSEPORT: 允许多个分片绑定同一端口，内核负责把新连接分流到各分片
+    setsockopt(reactor.listenFd, SOL_SOCKET, SO_REUSEPORT, (const void *)&optval, sizeof(int));
 
     // 绑定端口
     struct sockaddr_in addr;
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     addr.sin_port = htons(port_);
-    if (bind(listenFd_, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    if (bind(reactor.listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
     {
         return false;
     }
 
+    // 🌟 TCP_DEFER_ACCEPT: 三次握手完成且首包数据到达后才把连接交给 accept，
+    //    空握手（端口扫描、半开连接）根本不消耗 accept/epoll/定时器那一整套
+    if (sockPolicy_.deferAcceptSec > 0)
+    {
+        setsockopt(reactor.listenFd, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                   &sockPolicy_.deferAcceptSec, sizeof(int));
+    }
+
     // 监听（backlog 设为 1024，支撑高并发）
-    if (listen(listenFd_, 1024) < 0)
+    if (listen(reactor.listenFd, 1024) < 0)
     {
         return false;
     }
-    // 将 listenFd 挂载到 Epoll 上
-    epoller_->AddFd(listenFd_, listenEvent_ | EPOLLIN);
+    // 将 listenFd 挂载到本分片的 Epoll 上
+    reactor.epoller->AddFd(reactor.listenFd, listenEvent_ | EPOLLIN);
 
     // 设置非阻塞 (配合 ET 模式必须)
-    fcntl(listenFd_, F_SETFL, fcntl(listenFd_, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(reactor.listenFd, F_SETFL, fcntl(reactor.listenFd, F_GETFL, 0) | O_NONBLOCK);
     return true;
 } // 初始化监听 socket
+
 void WebServer::InitEventMode_()
 {
     listenEvent_ = EPOLLRDHUP;
@@ -133,79 +459,190 @@ void WebServer::InitEventMode_()
     connEvent_ |= EPOLLET;
     HttpConn::isET = true;
 } // 初始化事件模式（LT/ET）
-void WebServer::AddClient_(int fd, sockaddr_in addr)
+
+// slab 连接表：保证 fd 对应槽位存在（只在首次用到该 fd 时分配一次，之后一直复用）
+void WebServer::EnsureSlot_(Reactor &reactor, int fd)
 {
-    users_[fd].Init(fd, addr);
-    // 把新连接设为非阻塞
-    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
-    // 加入 Epoll 监听读事件
-    epoller_->AddFd(fd, EPOLLIN | connEvent_);
+    if (static_cast<size_t>(fd) >= reactor.users.size())
+    {
+        size_t newSize = reactor.users.size() < 1024 ? 1024 : reactor.users.size() * 2;
+        if (newSize <= static_cast<size_t>(fd)) { newSize = fd + 1; }
+        reactor.users.resize(newSize);
+        reactor.gens.resize(newSize, 0);
+    }
+    if (!reactor.users[fd])
+    {
+        reactor.users[fd].reset(new HttpConn());
+    }
+}
+
+// 取活跃连接：一次边界检查 + 一次数组寻址，槽位空或连接已关闭返回 nullptr
+HttpConn *WebServer::GetConn_(Reactor &reactor, int fd)
+{
+    if (fd < 0 || static_cast<size_t>(fd) >= reactor.users.size()) { return nullptr; }
+    HttpConn *client = reactor.users[fd].get();
+    if (!client || client->GetFd() != fd) { return nullptr; }
+    return client;
+}
+
+void WebServer::AddClient_(Reactor &reactor, int fd, sockaddr_in addr)
+{
+    EnsureSlot_(reactor, fd);
+    Metrics::Instance()->Inc(Metrics::C_CONN_ACCEPTED);
+    reactor.gens[fd]++; // 新连接新世代：让旧连接残留的定时器回调全部失效
+    reactor.users[fd]->Init(fd, addr);
+    // 按策略打 socket 选项（非阻塞已由 accept4 在内核里一并设好）
+    if (sockPolicy_.tcpNoDelay)
+    {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (sockPolicy_.rcvBufBytes > 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sockPolicy_.rcvBufBytes, sizeof(int));
+    }
+    if (sockPolicy_.sndBufBytes > 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sockPolicy_.sndBufBytes, sizeof(int));
+    }
+    // 加入本分片的 Epoll 监听读事件
+    reactor.epoller->AddFd(fd, EPOLLIN | connEvent_);
     // 添加定时器：超时后关闭该连接
     if (timeoutMS_ > 0)
     {
-        timer_->add(fd, timeoutMS_, [this, fd]()
-                    { CloseConn_(&users_[fd]); });
+        Reactor *r = &reactor;
+        uint32_t gen = reactor.gens[fd];
+        reactor.timer->add(fd, timeoutMS_, [this, r, fd, gen]()
+                           {
+                               // 世代号对不上说明 fd 已被新连接复用，这是个迟到的回调
+                               if (r->gens[fd] != gen) { return; }
+                               CloseConn_(*r, r->users[fd].get());
+                           });
     }
-
 } // 添加新客户端连接
-void WebServer::DealListen_()
+
+void WebServer::DealListen_(Reactor &reactor)
 {
     struct sockaddr_in addr;
     socklen_t len = sizeof(addr);
 
     // 因为是 ET 模式，必须把队列里所有的新连接一次性 accept 完
+    // 🌟 accept4(SOCK_NONBLOCK): 接受和设非阻塞合成一个 syscall，
+    //    省掉每连接两次 fcntl（连接风暴下 accept 路径就是恢复速度）
     while (true)
     {
-        int fd = accept(listenFd_, (struct sockaddr *)&addr, &len);
+        int fd = accept4(reactor.listenFd, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK);
         if (fd <= 0)
             break; // 没有新连接了
 
-        // 分配 HttpConn，加入 Epoll 监控
-        AddClient_(fd, addr);
+        // 分配 HttpConn，加入本分片的 Epoll 监控
+        AddClient_(reactor, fd, addr);
     }
 } // 处理监听事件
+
 // 关闭客户端
-void WebServer::CloseConn_(HttpConn *client)
+void WebServer::CloseConn_(Reactor &reactor, HttpConn *client)
 {
-    if(!client) return;
+    if (!client) return;
     int fd = client->GetFd();
-    if(fd < 0) return;  // 已经关闭过了，防止双重关闭
-    epoller_->DelFd(fd);
+    if (fd < 0) return; // 已经关闭过了，防止双重关闭
+    Metrics::Instance()->Inc(Metrics::C_CONN_CLOSED);
+    reactor.gens[fd]++; // 翻世代：残留的定时器回调对不上号，自动作废
+    reactor.epoller->DelFd(fd);
     // 注意：这里用 cancel 而不是 doWork，避免回调里再次 CloseConn_ 导致无限递归
-    timer_->cancel(fd);
+    reactor.timer->cancel(fd);
     client->Close();
 }
+
+// worker 线程投递延迟 epoll 操作并唤醒本分片的 reactor
+void WebServer::PostOp_(Reactor &reactor, EpollOp op)
+{
+    // 队列有界自带背压：塞满说明 reactor 严重滞后，让出 CPU 等它消化
+    while (!reactor.ops.Push(std::move(op)))
+    {
+        std::this_thread::yield();
+    }
+    // 去重唤醒：reactor 还没醒来处理上一次敲门时，不再重复写 eventfd（省系统调用）
+    bool expected = false;
+    if (reactor.wakePending.compare_exchange_strong(expected, true))
+    {
+        uint64_t one = 1;
+        ssize_t n = write(reactor.wakeFd, &one, sizeof(one));
+        (void)n; // eventfd 计数溢出几乎不可能，失败也只是多等一轮超时
+    }
+}
+
+// reactor 线程串行执行攒下的延迟操作
+void WebServer::DrainOps_(Reactor &reactor)
+{
+    // 先放行后续敲门，再清空队列：保证不会有操作卡在队列里没人唤醒
+    reactor.wakePending.store(false, std::memory_order_release);
+    EpollOp op;
+    while (reactor.ops.Pop(op))
+    {
+        // 连接指针和槽位对不上 → fd 在操作投递后已被关闭/复用，丢弃迟到操作
+        if (GetConn_(reactor, op.fd) != op.client) { continue; }
+        if (op.type == EpollOp::OP_MOD)
+        {
+            // 重新武装即表示 worker/DB 线程已放手，连接重新可被空闲扫描收缩
+            op.client->SetInFlight(false);
+            reactor.epoller->ModFd(op.fd, op.events);
+        }
+        else // OP_CLOSE
+        {
+            CloseConn_(reactor, op.client);
+        }
+    }
+}
+
 // --- 事件处理派发 ---
 // 处理监听事件
-void WebServer::DealRead_(HttpConn *client)
+void WebServer::DealRead_(Reactor &reactor, HttpConn *client)
 {
-    if(!client) return;
+    if (!client) return;
     // 客户端有活动，延长超时时间
-    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS_); }
-    threadpool_->AddTask([this, client]() { OnRead_(client); });
-} // 处理读事件(丢进线程池)
-void WebServer::DealWrite_(HttpConn *client)
+    if (timeoutMS_ > 0) { reactor.timer->adjust(client->GetFd(), timeoutMS_); }
+    Metrics::Instance()->Inc(Metrics::C_READ_EVENTS);
+    // 🌟 分段追踪抽样：每 64 个读事件抽 1 个，从事件出队这一刻起针。
+    // 计数器归 reactor 线程私有（非原子），未抽中只花一次自增加一个分支
+    if ((++reactor.traceTick & 63) == 0)
+    {
+        client->TraceArm(Metrics::NowTsc());
+    }
+    // 【修正】置调度在途标记：从这里到 DrainOps_ 重新武装 fd 之前，
+    // worker/DB 线程可能随时在动读写缓冲，空闲收缩扫描据此跳过本连接
+    client->SetInFlight(true);
+    Reactor *r = &reactor;
+    reactor.pending.emplace_back([this, r, client]() { OnRead_(*r, client); });
+} // 处理读事件(攒进本轮批次，稍后批量丢进线程池)
+
+void WebServer::DealWrite_(Reactor &reactor, HttpConn *client)
 {
-    if(!client) return;
+    if (!client) return;
     // 客户端有活动，延长超时时间
-    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS_); }
-    threadpool_->AddTask([this, client]() { OnWrite_(client); });
-} // 处理写事件（丢进线程池）
+    if (timeoutMS_ > 0) { reactor.timer->adjust(client->GetFd(), timeoutMS_); }
+    Metrics::Instance()->Inc(Metrics::C_WRITE_EVENTS);
+    client->SetInFlight(true); // 同 DealRead_：重新武装前不许收缩缓冲
+    Reactor *r = &reactor;
+    reactor.pending.emplace_back([this, r, client]() { OnWrite_(*r, client); });
+} // 处理写事件（攒进本轮批次，稍后批量丢进线程池）
 
 // --- 线程池实际执行的函数 ---
-void WebServer::OnRead_(HttpConn *client)
+void WebServer::OnRead_(Reactor &reactor, HttpConn *client)
 {
     int readErrno = 0;
     int ret = client->Read(&readErrno);
     if (ret <= 0 && readErrno != EAGAIN)
     {
-        CloseConn_(client); // 读错了，直接关掉
+        // 读错了直接关：worker 线程不能自己动 epoll/连接表，投递给 reactor 关
+        PostOp_(reactor, {EpollOp::OP_CLOSE, client->GetFd(), 0, client});
         return;
     }
     // 读取成功，开始状态机解析和处理业务
-    OnProcess_(client);
+    OnProcess_(reactor, client);
 }
-void WebServer::OnWrite_(HttpConn *client)
+
+void WebServer::OnWrite_(Reactor &reactor, HttpConn *client)
 {
     int writeErrno = 0;
     int ret = client->Write(&writeErrno);
@@ -214,28 +651,52 @@ void WebServer::OnWrite_(HttpConn *client)
         // 全发完了！如果是长连接，继续监听读事件；否则关掉
         if (client->IsKeepAlive())
         {
-            OnProcess_(client);
+            OnProcess_(reactor, client);
             return;
         }
     }
-    else if (ret < 0 && writeErrno == EAGAIN)
+    else if (ret > 0 || (ret < 0 && writeErrno == EAGAIN))
     {
-        // 缓冲区满了发不进去了，继续监听可写事件
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        // 缓冲区满（EAGAIN）或大文件发满一个 sendfile 窗口主动让位：
+        // 都重新武装可写事件，下一轮接着发
+        PostOp_(reactor, {EpollOp::OP_MOD, client->GetFd(), connEvent_ | EPOLLOUT, client});
         return;
     }
-    CloseConn_(client); // 其他情况或者短连接，直接关闭
+    // 其他情况或者短连接，投递给 reactor 关闭
+    PostOp_(reactor, {EpollOp::OP_CLOSE, client->GetFd(), 0, client});
 }
-void WebServer::OnProcess_(HttpConn *client)
+
+void WebServer::OnProcess_(Reactor &reactor, HttpConn *client)
 {
-    if (client->Process())
+    bool ready = client->Process();
+
+    // 🌟 DB 绑定路由被泊车：不重武装事件（EPOLLONESHOT 保持熄火），
+    // 先把空闲定时器续满一轮，再把连接交给专职 DB 线程池；
+    // worker 立刻回去处理下一个任务，数据库慢不会堵住静态文件路径
+    if (client->HasPendingDb())
+    {
+        Reactor *r = &reactor;
+        reactor.timer->adjust(client->GetFd(), timeoutMS_);
+        dbPool_->AddTask([this, r, client]() { OnDbWork_(*r, client); });
+        return;
+    }
+
+    if (ready)
     {
         // 解析成功，有数据要发，监听可写事件
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        PostOp_(reactor, {EpollOp::OP_MOD, client->GetFd(), connEvent_ | EPOLLOUT, client});
     }
     else
     {
         // 解析失败或者数据没收全，继续监听可读事件
-        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+        PostOp_(reactor, {EpollOp::OP_MOD, client->GetFd(), connEvent_ | EPOLLIN, client});
     }
-}
\ No newline at end of file
+}
+
+// 在 DB 线程上完成数据库往返和响应组装，然后经延迟操作队列 + eventfd
+// 把连接交还给 reactor 武装 EPOLLOUT（fd 被复用的迟到交还会被 DrainOps_ 识别丢弃）
+void WebServer::OnDbWork_(Reactor &reactor, HttpConn *client)
+{
+    client->RunPendingDb();
+    PostOp_(reactor, {EpollOp::OP_MOD, client->GetFd(), connEvent_ | EPOLLOUT, client});
+}
@@ -0,0 +1,223 @@
+/*
+ * blogcat：二进制日志段文件（.blog）离线渲染工具
+ *
+ * 服务器开二进制日志模式后，业务线程只写"格式串 ID + 原始参数字节"，
+ * 所有格式化推迟到这里。用法：
+ *
+ *     ./blogcat log/2026_08_29_000.blog [more.blog ...]
+ *
+ * 两遍扫描：第一遍收集所有格式串定义帧（定义帧可能晚于别的线程的
+ * 记录帧落盘），第二遍按时间顺序渲染记录帧为文本行输出到 stdout。
+ * 帧格式见 src/log.cpp 顶部的注释。
+ */
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+static const char BLOG_MAGIC[8] = {'W', 'S', 'B', 'L', 'O', 'G', '0', '1'};
+static const uint8_t FRAME_FMTDEF = 1;
+static const uint8_t FRAME_RECORD = 2;
+
+// 按 payload 游标读参数字节，越界返回 false（段尾截断帧自然终止）
+struct PayloadReader {
+    const char* p;
+    const char* end;
+    bool ReadI64(int64_t* v) {
+        if (end - p < 8) { return false; }
+        memcpy(v, p, 8); p += 8;
+        return true;
+    }
+    bool ReadF64(double* v) {
+        if (end - p < 8) { return false; }
+        memcpy(v, p, 8); p += 8;
+        return true;
+    }
+    bool ReadStr(std::string* s) {
+        uint16_t len;
+        if (end - p < 2) { return false; }
+        memcpy(&len, p, 2); p += 2;
+        if (end - p < (std::ptrdiff_t)len) { return false; }
+        s->assign(p, len);
+        p += len;
+        return true;
+    }
+};
+
+// 把一条记录帧按格式串渲染成文本（镜像 Log::EncodeArgs_ 的序列化顺序）
+static std::string RenderRecord(const std::string& fmt, const char* payload, size_t plen) {
+    std::string out;
+    PayloadReader r{payload, payload + plen};
+    char tmp[1024];
+
+    const char* p = fmt.c_str();
+    while (*p) {
+        if (*p != '%') { out.push_back(*p++); continue; }
+        ++p;
+        if (*p == '%') { out.push_back('%'); ++p; continue; }
+
+        std::string spec = "%";
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') { spec.push_back(*p++); }
+        if (*p == '*') { // 宽度从参数来
+            int64_t w;
+            if (!r.ReadI64(&w)) { break; }
+            spec += std::to_string(w);
+            ++p;
+        } else { while (isdigit((unsigned char)*p)) { spec.push_back(*p++); } }
+        if (*p == '.') {
+            spec.push_back(*p++);
+            if (*p == '*') {
+                int64_t pr;
+                if (!r.ReadI64(&pr)) { break; }
+                spec += std::to_string(pr);
+                ++p;
+            } else { while (isdigit((unsigned char)*p)) { spec.push_back(*p++); } }
+        }
+        // 长度修饰符全部丢弃：整数统一按 8 字节序列化，渲染时统一用 ll
+        while (*p == 'l' || *p == 'h' || *p == 'z' || *p == 't') { ++p; }
+
+        char conv = *p ? *p++ : '\0';
+        tmp[0] = '\0';
+        switch (conv) {
+            case 'd': case 'i': {
+                int64_t v;
+                if (!r.ReadI64(&v)) { return out; }
+                spec += "lld";
+                snprintf(tmp, sizeof(tmp), spec.c_str(), (long long)v);
+                break;
+            }
+            case 'u': case 'o': case 'x': case 'X': {
+                int64_t v;
+                if (!r.ReadI64(&v)) { return out; }
+                spec += "ll"; spec.push_back(conv);
+                snprintf(tmp, sizeof(tmp), spec.c_str(), (unsigned long long)v);
+                break;
+            }
+            case 'c': {
+                int64_t v;
+                if (!r.ReadI64(&v)) { return out; }
+                spec.push_back('c');
+                snprintf(tmp, sizeof(tmp), spec.c_str(), (int)v);
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': {
+                double v;
+                if (!r.ReadF64(&v)) { return out; }
+                spec.push_back(conv);
+                snprintf(tmp, sizeof(tmp), spec.c_str(), v);
+                break;
+            }
+            case 's': {
+                std::string s;
+                if (!r.ReadStr(&s)) { return out; }
+                spec.push_back('s');
+                snprintf(tmp, sizeof(tmp), spec.c_str(), s.c_str());
+                break;
+            }
+            case 'p': {
+                int64_t v;
+                if (!r.ReadI64(&v)) { return out; }
+                snprintf(tmp, sizeof(tmp), "0x%llx", (unsigned long long)v);
+                break;
+            }
+            default: continue; // 未知转换：原样丢弃
+        }
+        out += tmp;
+    }
+    return out;
+}
+
+static const char* LevelName(uint8_t level) {
+    switch (level) {
+        case 0: return "[DEBUG]";
+        case 1: return "[INFO] ";
+        case 2: return "[WARN] ";
+        case 3: return "[ERROR]";
+        default: return "[????] ";
+    }
+}
+
+// 【修正】fmts 由 main 传入并跨输入文件累积：写端每个格式串 ID 在进程
+// 生命期内只发一次定义帧（段滚动不重发），所以滚动后的段要靠前面
+// 段里收到的定义才能渲染。ID 是进程内单调分配的，跨文件不会撞号
+static bool RenderFile(const char* filename, std::unordered_map<uint32_t, std::string>& fmts) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) { fprintf(stderr, "blogcat: cannot open %s\n", filename); return false; }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    std::vector<char> data(size > 0 ? (size_t)size : 0);
+    if (size > 0 && fread(data.data(), 1, (size_t)size, fp) != (size_t)size) {
+        fclose(fp);
+        fprintf(stderr, "blogcat: short read on %s\n", filename);
+        return false;
+    }
+    fclose(fp);
+
+    if (data.size() < sizeof(BLOG_MAGIC) ||
+        memcmp(data.data(), BLOG_MAGIC, sizeof(BLOG_MAGIC)) != 0) {
+        fprintf(stderr, "blogcat: %s is not a binary log segment\n", filename);
+        return false;
+    }
+
+    // 两遍扫描：pass 0 只收定义帧，pass 1 渲染记录帧
+    for (int pass = 0; pass < 2; pass++) {
+        size_t off = sizeof(BLOG_MAGIC);
+        while (off < data.size()) {
+            uint8_t type = (uint8_t)data[off];
+            if (type == FRAME_FMTDEF) {
+                if (off + 7 > data.size()) { break; }
+                uint32_t id; uint16_t len;
+                memcpy(&id, &data[off + 1], 4);
+                memcpy(&len, &data[off + 5], 2);
+                if (off + 7 + len > data.size()) { break; }
+                if (pass == 0) { fmts[id].assign(&data[off + 7], len); }
+                off += 7 + len;
+            } else if (type == FRAME_RECORD) {
+                if (off + 20 > data.size()) { break; }
+                uint32_t id; uint8_t level; int64_t sec; uint32_t usec; uint16_t plen;
+                memcpy(&id, &data[off + 1], 4);
+                memcpy(&level, &data[off + 5], 1);
+                memcpy(&sec, &data[off + 6], 8);
+                memcpy(&usec, &data[off + 14], 4);
+                memcpy(&plen, &data[off + 18], 2);
+                if (off + 20 + plen > data.size()) { break; }
+                if (pass == 1) {
+                    auto it = fmts.find(id);
+                    std::string line = (it != fmts.end())
+                        ? RenderRecord(it->second, &data[off + 20], plen)
+                        : "<unknown format id " + std::to_string(id) + ">";
+                    time_t t = (time_t)sec;
+                    struct tm tmv;
+                    localtime_r(&t, &tmv);
+                    printf("%04d-%02d-%02d %02d:%02d:%02d.%06u %s %s\n",
+                           tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday,
+                           tmv.tm_hour, tmv.tm_min, tmv.tm_sec, usec,
+                           LevelName(level), line.c_str());
+                }
+                off += 20 + (size_t)plen;
+            } else {
+                break; // 预分配段尾的零字节：该段到此为止
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <segment.blog> [more.blog ...]\n", argv[0]);
+        return 1;
+    }
+    int rc = 0;
+    std::unordered_map<uint32_t, std::string> fmts; // 跨所有输入段累积的格式串表
+    for (int i = 1; i < argc; i++) {
+        if (!RenderFile(argv[i], fmts)) { rc = 1; }
+    }
+    return rc;
+}